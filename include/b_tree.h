@@ -0,0 +1,575 @@
+#if not defined(F6F4C139A7904A2E85677512715221D9)
+#define F6F4C139A7904A2E85677512715221D9
+#if defined(F6F4C139A7904A2E85677512715221D9)
+
+#include "intrusive.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+/* A B+ tree over the objects of a random access range. Unlike the binary trees the objects only need a key; the tree itself lives in the objects of a second
+ * random access range of nodes. tree_type provides key_type like red_black_tree, and for the nodes size_type, level_type, next_type and prev_type, which are
+ * explicitly convertible to and from difference_type, and keys_type and links_type, which are fixed size arrays of the same length called the order of the
+ * tree. get for keys_type and links_type must return references. A node of level 0 is a leaf whose links index the objects and whose keys are copies of
+ * their keys, leaves are chained in key order by next and prev. The links of higher nodes index their children, and key i is a lower bound of the keys
+ * under child i for i > 0. Every node but the root is at least half full.
+ *
+ * Nodes not in the tree are kept on a free list linked through next_type, which init builds and which insert and erase take from and give back to. Both
+ * return the new root and the new head of the free list. The node range should hold node_capacity nodes for the most objects the tree will hold.
+*/
+namespace b_tree {
+	namespace detail {
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		struct b_tree_node final
+		{
+			node_base_type base;
+			using size_type = typename tree_type::size_type;
+			using level_type = typename tree_type::level_type;
+			using next_type = typename tree_type::next_type;
+			using prev_type = typename tree_type::prev_type;
+			using keys_type = typename tree_type::keys_type;
+			using links_type = typename tree_type::links_type;
+			using difference_type = typename std::iterator_traits<node_base_type>::difference_type;
+			static constexpr auto order = difference_type(std::tuple_size_v<links_type>);
+			static_assert(order >= 4 and std::tuple_size_v<keys_type> == std::tuple_size_v<links_type>);
+
+			difference_type link;
+			[[nodiscard]] constexpr auto size() const noexcept { return difference_type(size_type(intrusive::_get<size_type>(base[link - 1]))); }
+			[[nodiscard]] constexpr auto level() const noexcept { return difference_type(level_type(intrusive::_get<level_type>(base[link - 1]))); }
+			[[nodiscard]] constexpr auto next() const noexcept { return b_tree_node{ base, difference_type(next_type(intrusive::_get<next_type>(base[link - 1]))) }; }
+			[[nodiscard]] constexpr auto prev() const noexcept { return b_tree_node{ base, difference_type(prev_type(intrusive::_get<prev_type>(base[link - 1]))) }; }
+			[[nodiscard]] constexpr decltype(auto) keys() const noexcept { return intrusive::_get<keys_type>(base[link - 1]); }
+			[[nodiscard]] constexpr decltype(auto) links() const noexcept { return intrusive::_get<links_type>(base[link - 1]); }
+			[[nodiscard]] constexpr auto entry(difference_type i) const noexcept { return difference_type(links()[std::size_t(i)]); }
+			[[nodiscard]] constexpr auto child(difference_type i) const noexcept { return b_tree_node{ base, entry(i) }; }
+
+			constexpr auto size(difference_type size) const noexcept { intrusive::_get<size_type>(base[link - 1]) = size_type(size); }
+			constexpr auto level(difference_type level) const noexcept { intrusive::_get<level_type>(base[link - 1]) = level_type(level); }
+			constexpr auto next(const b_tree_node& next) const noexcept { intrusive::_get<next_type>(base[link - 1]) = next_type(next.link); }
+			constexpr auto prev(const b_tree_node& prev) const noexcept { intrusive::_get<prev_type>(base[link - 1]) = prev_type(prev.link); }
+			constexpr auto entry(difference_type i, difference_type entry) const noexcept { links()[std::size_t(i)] = typename links_type::value_type(entry); }
+			[[nodiscard]] constexpr decltype(auto) key(difference_type i) const noexcept { return keys()[std::size_t(i)]; }
+			[[nodiscard]] constexpr auto keys_begin() const noexcept { return keys().begin(); }
+			[[nodiscard]] constexpr auto keys_end() const noexcept { return keys().begin() + size(); }
+
+			[[nodiscard]] constexpr auto operator==(const b_tree_node& other) const noexcept { return link == other.link; }
+			[[nodiscard]] constexpr auto operator!=(const b_tree_node& other) const noexcept { return link not_eq other.link; }
+			[[nodiscard]] explicit constexpr operator bool() const noexcept { return bool(link); }
+			[[nodiscard]] explicit constexpr operator difference_type() const noexcept { return link; }
+		};
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto element_key(base_type base, typename std::iterator_traits<base_type>::difference_type x) noexcept
+		{
+			using key_type = typename tree_type::keys_type::value_type;
+			return key_type(typename tree_type::key_type(intrusive::_get<typename tree_type::key_type>(base[x - 1])));
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		[[nodiscard]] constexpr auto min_size() noexcept
+		{
+			return b_tree_node<tree_type, node_base_type>::order / 2;
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto move_entry(const b_tree_node<tree_type, node_base_type> dst, typename std::iterator_traits<node_base_type>::difference_type i, const b_tree_node<tree_type, node_base_type> src, typename std::iterator_traits<node_base_type>::difference_type j) noexcept
+		{
+			dst.keys()[std::size_t(i)] = src.key(j);
+			dst.entry(i, src.entry(j));
+		}
+
+		// Opens a gap at i by moving the entries from i on one to the right. The size is not changed.
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto shift_right(const b_tree_node<tree_type, node_base_type> x, typename std::iterator_traits<node_base_type>::difference_type i) noexcept
+		{
+			for (auto j = x.size(); j > i; --j)
+				detail::move_entry(x, j, x, j - 1);
+		}
+
+		// Closes the gap at i by moving the entries after it one to the left. The size is not changed.
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto shift_left(const b_tree_node<tree_type, node_base_type> x, typename std::iterator_traits<node_base_type>::difference_type i) noexcept
+		{
+			for (auto j = i + 1; j < x.size(); ++j)
+				detail::move_entry(x, j - 1, x, j);
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		[[nodiscard]] constexpr auto allocate(node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type& free_list, typename std::iterator_traits<node_base_type>::difference_type level) noexcept
+		{
+			const auto x = b_tree_node<tree_type, node_base_type>{ nodes, free_list };
+			free_list = x.next().link;
+			x.size(0);
+			x.level(level);
+			x.next({});
+			x.prev({});
+			return x;
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto release(typename std::iterator_traits<node_base_type>::difference_type& free_list, const b_tree_node<tree_type, node_base_type> x) noexcept
+		{
+			x.next(b_tree_node<tree_type, node_base_type>{ x.base, free_list });
+			free_list = x.link;
+		}
+
+		// The child of inner node x to descend into for value. upper picks the last child that can hold value, otherwise the first.
+		template <bool upper, typename tree_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto route(const b_tree_node<tree_type, node_base_type> x, const V& value, less_type& less) noexcept
+		{
+			using difference_type = typename std::iterator_traits<node_base_type>::difference_type;
+			if constexpr (upper)
+				return difference_type(std::upper_bound(x.keys_begin() + 1, x.keys_end(), value, [&](const auto& a, const auto& b) { return less(a, b); }) - (x.keys_begin() + 1));
+			else
+				return difference_type(std::lower_bound(x.keys_begin() + 1, x.keys_end(), value, [&](const auto& a, const auto& b) { return less(a, b); }) - (x.keys_begin() + 1));
+		}
+
+		template <bool upper, typename tree_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto slot(const b_tree_node<tree_type, node_base_type> x, const V& value, less_type& less) noexcept
+		{
+			using difference_type = typename std::iterator_traits<node_base_type>::difference_type;
+			if constexpr (upper)
+				return difference_type(std::upper_bound(x.keys_begin(), x.keys_end(), value, [&](const auto& a, const auto& b) { return less(a, b); }) - x.keys_begin());
+			else
+				return difference_type(std::lower_bound(x.keys_begin(), x.keys_end(), value, [&](const auto& a, const auto& b) { return less(a, b); }) - x.keys_begin());
+		}
+
+		// Returns the leaf and slot of the first entry not ordered before value, or after it when upper. A slot past the end of a leaf becomes the next leaf.
+		template <bool upper, typename tree_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_bound(b_tree_node<tree_type, node_base_type> x, const V& value, less_type less) noexcept
+		{
+			using difference_type = typename std::iterator_traits<node_base_type>::difference_type;
+			if (not x)
+				return std::pair{ x, difference_type{} };
+			while (x.level())
+				x = x.child(detail::route<upper>(x, value, less));
+			auto i = detail::slot<upper>(x, value, less);
+			if (i == x.size())
+				return std::pair{ x.next(), difference_type{} };
+			return std::pair{ x, i };
+		}
+
+		// Moves the upper half of the full child i of parent to a new node linked in after it.
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto split_child(const b_tree_node<tree_type, node_base_type> parent, typename std::iterator_traits<node_base_type>::difference_type i, typename std::iterator_traits<node_base_type>::difference_type& free_list) noexcept
+		{
+			const auto c = parent.child(i);
+			const auto s = detail::allocate<tree_type>(parent.base, free_list, c.level());
+			const auto m = c.size() / 2;
+			for (auto j = m; j < c.size(); ++j)
+				detail::move_entry(s, j - m, c, j);
+			s.size(c.size() - m);
+			c.size(m);
+			if (not c.level()) {
+				s.next(c.next());
+				s.prev(c);
+				if (c.next())
+					c.next().prev(s);
+				c.next(s);
+			}
+			detail::shift_right(parent, i + 1);
+			parent.keys()[std::size_t(i + 1)] = s.key(0);
+			parent.entry(i + 1, s.link);
+			parent.size(parent.size() + 1);
+		}
+
+		// Inserts the object z, splitting full nodes on the way down so there is always room for the split of a child. Returns the leaf, the slot and the root.
+		template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_insert(base_type base, b_tree_node<tree_type, node_base_type> root, typename std::iterator_traits<node_base_type>::difference_type& free_list, typename std::iterator_traits<base_type>::difference_type z, less_type less) noexcept
+		{
+			using node_type = b_tree_node<tree_type, node_base_type>;
+			using key_type = typename tree_type::keys_type::value_type;
+			const auto key = key_type(detail::element_key<tree_type>(base, z));
+			if (not root)
+				root = detail::allocate<tree_type>(root.base, free_list, 0);
+			else if (root.size() == node_type::order) {
+				const auto new_root = detail::allocate<tree_type>(root.base, free_list, root.level() + 1);
+				new_root.keys()[0] = root.key(0);
+				new_root.entry(0, root.link);
+				new_root.size(1);
+				detail::split_child(new_root, 0, free_list);
+				root = new_root;
+			}
+			auto x = root;
+			while (x.level()) {
+				auto i = detail::route<true>(x, key, less);
+				if (x.child(i).size() == node_type::order) {
+					detail::split_child(x, i, free_list);
+					if (not less(key, x.key(i + 1)))
+						++i;
+				}
+				x = x.child(i);
+			}
+			const auto i = detail::slot<true>(x, key, less);
+			detail::shift_right(x, i);
+			x.keys()[std::size_t(i)] = key;
+			x.entry(i, z);
+			x.size(x.size() + 1);
+			return std::tuple{ x, i, root };
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto borrow_from_left(const b_tree_node<tree_type, node_base_type> parent, typename std::iterator_traits<node_base_type>::difference_type i, const b_tree_node<tree_type, node_base_type> left, const b_tree_node<tree_type, node_base_type> x) noexcept
+		{
+			detail::shift_right(x, 0);
+			detail::move_entry(x, 0, left, left.size() - 1);
+			if (x.level())
+				x.keys()[1] = parent.key(i);
+			parent.keys()[std::size_t(i)] = x.key(0);
+			left.size(left.size() - 1);
+			x.size(x.size() + 1);
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto borrow_from_right(const b_tree_node<tree_type, node_base_type> parent, typename std::iterator_traits<node_base_type>::difference_type i, const b_tree_node<tree_type, node_base_type> x, const b_tree_node<tree_type, node_base_type> right) noexcept
+		{
+			detail::move_entry(x, x.size(), right, 0);
+			if (x.level())
+				x.keys()[std::size_t(x.size())] = parent.key(i + 1);
+			detail::shift_left(right, 0);
+			right.size(right.size() - 1);
+			x.size(x.size() + 1);
+			parent.keys()[std::size_t(i + 1)] = right.key(0);
+		}
+
+		// Appends child i + 1 of parent, right, to child i, left, and frees it.
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		constexpr auto merge(const b_tree_node<tree_type, node_base_type> parent, typename std::iterator_traits<node_base_type>::difference_type i, const b_tree_node<tree_type, node_base_type> left, const b_tree_node<tree_type, node_base_type> right, typename std::iterator_traits<node_base_type>::difference_type& free_list) noexcept
+		{
+			const auto n = left.size();
+			for (auto j = typename std::iterator_traits<node_base_type>::difference_type{}; j < right.size(); ++j)
+				detail::move_entry(left, n + j, right, j);
+			if (left.level())
+				left.keys()[std::size_t(n)] = parent.key(i + 1);
+			else {
+				left.next(right.next());
+				if (right.next())
+					right.next().prev(left);
+			}
+			left.size(n + right.size());
+			detail::shift_left(parent, i + 1);
+			parent.size(parent.size() - 1);
+			detail::release(free_list, right);
+		}
+
+		// The inner nodes from the root down to a leaf, and which child was taken at each.
+		template <std::random_access_iterator node_base_type>
+		struct path final
+		{
+			using difference_type = typename std::iterator_traits<node_base_type>::difference_type;
+
+			std::array<difference_type, std::numeric_limits<difference_type>::digits> nodes;
+			std::array<difference_type, std::numeric_limits<difference_type>::digits> children;
+			difference_type depth;
+		};
+
+		// Removes entry i of leaf, which must be in the tree rooted at root, and refills or merges the nodes it leaves less than half full. Returns the root.
+		template <typename tree_type, std::random_access_iterator node_base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_erase(b_tree_node<tree_type, node_base_type> root, typename std::iterator_traits<node_base_type>::difference_type& free_list, const b_tree_node<tree_type, node_base_type> leaf, typename std::iterator_traits<node_base_type>::difference_type i, less_type less) noexcept
+		{
+			using node_type = b_tree_node<tree_type, node_base_type>;
+			using key_type = typename tree_type::keys_type::value_type;
+			const auto key = key_type(leaf.key(i));
+
+			auto p = path<node_base_type>{};
+			auto x = root;
+			for (; x.level(); x = x.child(p.children[std::size_t(p.depth++)])) {
+				p.nodes[std::size_t(p.depth)] = x.link;
+				p.children[std::size_t(p.depth)] = detail::route<false>(x, key, less);
+			}
+			while (x not_eq leaf) {
+				auto d = p.depth - 1;
+				while (p.children[std::size_t(d)] + 1 == node_type{ root.base, p.nodes[std::size_t(d)] }.size())
+					--d;
+				x = node_type{ root.base, p.nodes[std::size_t(d)] }.child(++p.children[std::size_t(d)]);
+				for (++d; d < p.depth; ++d) {
+					p.nodes[std::size_t(d)] = x.link;
+					p.children[std::size_t(d)] = 0;
+					x = x.child(0);
+				}
+			}
+
+			detail::shift_left(x, i);
+			x.size(x.size() - 1);
+			while (x not_eq root and x.size() < detail::min_size<tree_type, node_base_type>()) {
+				--p.depth;
+				const auto parent = node_type{ root.base, p.nodes[std::size_t(p.depth)] };
+				const auto j = p.children[std::size_t(p.depth)];
+				const auto left = j > 0 ? parent.child(j - 1) : node_type{};
+				const auto right = j + 1 < parent.size() ? parent.child(j + 1) : node_type{};
+				if (left and left.size() > detail::min_size<tree_type, node_base_type>()) {
+					detail::borrow_from_left(parent, j, left, x);
+					break;
+				}
+				if (right and right.size() > detail::min_size<tree_type, node_base_type>()) {
+					detail::borrow_from_right(parent, j, x, right);
+					break;
+				}
+				if (left)
+					detail::merge(parent, j - 1, left, x, free_list);
+				else
+					detail::merge(parent, j, x, right, free_list);
+				x = parent;
+			}
+
+			if (not root.size()) {
+				detail::release(free_list, root);
+				root = node_type{ root.base, 0 };
+			} else if (root.level() and root.size() == 1) {
+				const auto old_root = root;
+				root = root.child(0);
+				detail::release(free_list, old_root);
+			}
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator node_base_type>
+		[[nodiscard]] constexpr auto check_index(b_tree_node<tree_type, node_base_type> curr, typename std::iterator_traits<node_base_type>::difference_type extent) noexcept
+		{
+			using T = typename std::iterator_traits<node_base_type>::difference_type;
+			return T{} < T(curr) and T(curr) <= extent;
+		}
+
+		struct validation final
+		{
+			std::ptrdiff_t extent;
+			std::ptrdiff_t node_extent;
+			std::ptrdiff_t visited;
+			std::ptrdiff_t prev_leaf;
+		};
+
+		// Checks the subtree at x, whose keys must not be ordered before lo or after hi when those are given, and the chaining of its leaves.
+		template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename key_ptr, typename less_type>
+		[[nodiscard]] constexpr auto do_validate(base_type base, b_tree_node<tree_type, node_base_type> x, bool is_root, key_ptr lo, key_ptr hi, validation& v, less_type& less) noexcept -> bool
+		{
+			using node_type = b_tree_node<tree_type, node_base_type>;
+			if (not detail::check_index(x, v.node_extent) or ++v.visited > v.node_extent)
+				return false;
+			if (x.size() > node_type::order or x.size() < (is_root ? x.level() ? 2 : 1 : detail::min_size<tree_type, node_base_type>()))
+				return false;
+			for (auto i = x.level() ? 1 : 0; i < x.size(); ++i) {
+				if (i > (x.level() ? 1 : 0) and less(x.key(i), x.key(i - 1)))
+					return false;
+				if ((lo and less(x.key(i), *lo)) or (hi and less(*hi, x.key(i))))
+					return false;
+			}
+			if (not x.level()) {
+				if (x.prev().link not_eq v.prev_leaf or (v.prev_leaf and b_tree_node<tree_type, node_base_type>{ x.base, v.prev_leaf }.next() not_eq x))
+					return false;
+				v.prev_leaf = x.link;
+				for (auto i = 0; i < x.size(); ++i) {
+					const auto e = x.entry(i);
+					if (e <= 0 or e > v.extent)
+						return false;
+					const auto& key = x.key(i);
+					const auto element = typename tree_type::keys_type::value_type(detail::element_key<tree_type>(base, e));
+					if (less(key, element) or less(element, key))
+						return false;
+				}
+				return true;
+			}
+			for (auto i = 0; i < x.size(); ++i) {
+				const auto c = x.child(i);
+				if (not detail::check_index(c, v.node_extent) or c.level() + 1 not_eq x.level())
+					return false;
+				auto c_lo = i ? &x.key(i) : lo;
+				auto c_hi = i + 1 < x.size() ? &x.key(i + 1) : hi;
+				if (not detail::do_validate(base, c, false, c_lo, c_hi, v, less))
+					return false;
+			}
+			return true;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_validate(base_type base, typename std::iterator_traits<base_type>::difference_type extent, b_tree_node<tree_type, node_base_type> root, typename std::iterator_traits<node_base_type>::difference_type node_extent, less_type less) noexcept
+		{
+			using key_ptr = const typename tree_type::keys_type::value_type*;
+			if (not root)
+				return true;
+			auto v = validation{ std::ptrdiff_t(extent), std::ptrdiff_t(node_extent), 0, 0 };
+			if (not detail::do_validate(base, root, true, key_ptr{}, key_ptr{}, v, less))
+				return false;
+			return not b_tree_node<tree_type, node_base_type>{ root.base, v.prev_leaf }.next();
+		}
+	}
+
+	// The number of nodes a tree holding n objects can need at most.
+	template <typename tree_type>
+	[[nodiscard]] constexpr auto node_capacity(std::ptrdiff_t n) noexcept
+	{
+		constexpr auto half = std::ptrdiff_t(std::tuple_size_v<typename tree_type::links_type>) / 2;
+		return 2 * ((n + half - 1) / half) + 1;
+	}
+
+	// Links the nodes in [first, last) into a free list and returns its head.
+	template <typename tree_type, std::random_access_iterator node_base_type>
+	[[nodiscard]] constexpr auto init(node_base_type first, node_base_type last) noexcept
+	{
+		using difference_type = std::iterator_traits<node_base_type>::difference_type;
+		using node_type = detail::b_tree_node<tree_type, node_base_type>;
+		auto n = difference_type(std::distance(first, last));
+		for (auto i = difference_type{1}; i <= n; ++i)
+			node_type{ first, i }.next(node_type{ first, i < n ? i + 1 : 0 });
+		return n ? difference_type{1} : difference_type{};
+	}
+
+	/* Implements a forward iterator over the objects of a b_tree in key order. It stays valid until the tree is next modified.
+	 * This class implements bidirectional iterator except end is not decrementable.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type>
+	struct forward_iter final
+	{
+		using value_type = std::iterator_traits<base_type>::value_type;
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using reference = std::iterator_traits<base_type>::reference;
+		using pointer = std::iterator_traits<base_type>::pointer;
+		using iterator_category = std::forward_iterator_tag;
+
+		base_type base;
+		node_base_type nodes;
+		std::iterator_traits<node_base_type>::difference_type leaf;
+		std::iterator_traits<node_base_type>::difference_type slot;
+		[[nodiscard]] constexpr auto link() const noexcept { return detail::b_tree_node<tree_type, node_base_type>{ nodes, leaf }.entry(slot); }
+		constexpr decltype(auto) operator++() noexcept
+		{
+			auto x = detail::b_tree_node<tree_type, node_base_type>{ nodes, leaf };
+			if (++slot == x.size()) {
+				leaf = x.next().link;
+				slot = 0;
+			}
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator++(int) noexcept { auto copy = *this; ++(*this); return copy; }
+		constexpr decltype(auto) operator--() noexcept
+		{
+			if (slot)
+				--slot;
+			else {
+				leaf = detail::b_tree_node<tree_type, node_base_type>{ nodes, leaf }.prev().link;
+				slot = detail::b_tree_node<tree_type, node_base_type>{ nodes, leaf }.size() - 1;
+			}
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator--(int) noexcept { auto copy = *this; --(*this); return copy; }
+		[[nodiscard]] constexpr decltype(auto) operator*() const noexcept { return base[link() - 1]; }
+		[[nodiscard]] constexpr auto operator->() const noexcept { return base + (link() - 1); }
+		[[nodiscard]] constexpr decltype(auto) operator*() noexcept { return base[link() - 1]; }
+		[[nodiscard]] constexpr auto operator->() noexcept { return base + (link() - 1); }
+		template <typename other_base, typename other_nodes>
+		[[nodiscard]] constexpr auto operator==(const forward_iter<tree_type, other_base, other_nodes>& other) const noexcept { return leaf == other.leaf and slot == other.slot; }
+		template <typename other_base, typename other_nodes>
+		[[nodiscard]] constexpr auto operator!=(const forward_iter<tree_type, other_base, other_nodes>& other) const noexcept { return not (*this == other); }
+	};
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type>
+	[[nodiscard]] constexpr auto end(base_type base, node_base_type nodes) noexcept
+	{
+		return forward_iter<tree_type, base_type, node_base_type>{ base, nodes, {}, {} };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type>
+	[[nodiscard]] constexpr auto begin(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root) noexcept
+	{
+		auto x = detail::b_tree_node<tree_type, node_base_type>{ nodes, root };
+		while (x and x.level())
+			x = x.child(0);
+		return forward_iter<tree_type, base_type, node_base_type>{ base, nodes, x.link, {} };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto lower_bound(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto [x, i] = detail::do_bound<false>(detail::b_tree_node<tree_type, node_base_type>{ nodes, root }, value, less);
+		return forward_iter<tree_type, base_type, node_base_type>{ base, nodes, x.link, i };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto upper_bound(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto [x, i] = detail::do_bound<true>(detail::b_tree_node<tree_type, node_base_type>{ nodes, root }, value, less);
+		return forward_iter<tree_type, base_type, node_base_type>{ base, nodes, x.link, i };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto find(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto it = lower_bound<tree_type>(base, nodes, root, value, less);
+		if (it.leaf and less(value, detail::b_tree_node<tree_type, node_base_type>{ nodes, it.leaf }.key(it.slot)))
+			return end<tree_type>(base, nodes);
+		return it;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto equal_range(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		return std::pair{ lower_bound<tree_type>(base, nodes, root, value, less), upper_bound<tree_type>(base, nodes, root, value, less) };
+	}
+
+	// Makes an iterator to the object pointed to by it, which must be in the tree rooted at root. The objects don't know their leaf, so this searches by key.
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename less_type>
+	[[nodiscard]] constexpr auto make_iterator(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root, base_type it, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using key_type = typename tree_type::keys_type::value_type;
+		auto z = difference_type(std::distance(base, it) + 1);
+		auto result = lower_bound<tree_type>(base, nodes, root, key_type(detail::element_key<tree_type>(base, z)), less);
+		while (result.leaf and result.link() not_eq z)
+			++result;
+		return result;
+	}
+
+	/* Inserts the object pointed to by it into the tree rooted at root, after any objects with an equal key. returns an iterator to it, the new root and the
+	 * new head of the free list. The free list must have enough nodes, which node_capacity of the new size guarantees.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename less_type>
+	[[nodiscard]] constexpr auto insert(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root, typename std::iterator_traits<node_base_type>::difference_type free_list, base_type it, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::b_tree_node<tree_type, node_base_type>;
+		auto [x, i, r] = detail::do_insert(base, node_type{ nodes, root }, free_list, difference_type(std::distance(base, it) + 1), less);
+		return std::tuple{ forward_iter<tree_type, base_type, node_base_type>{ base, nodes, x.link, i }, r.link, free_list };
+	}
+
+	// Erases the object at it from the tree rooted at root. returns the new root and the new head of the free list.
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename less_type>
+	[[nodiscard]] constexpr auto erase(typename std::iterator_traits<node_base_type>::difference_type root, typename std::iterator_traits<node_base_type>::difference_type free_list, forward_iter<tree_type, base_type, node_base_type> it, less_type less) noexcept
+	{
+		using node_type = detail::b_tree_node<tree_type, node_base_type>;
+		auto r = detail::do_erase(node_type{ it.nodes, root }, free_list, node_type{ it.nodes, it.leaf }, it.slot, less);
+		return std::pair{ r.link, free_list };
+	}
+
+	template <std::random_access_iterator node_base_type>
+	[[nodiscard]] constexpr auto empty(typename std::iterator_traits<node_base_type>::difference_type root) noexcept
+	{
+		return not root;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type>
+	[[nodiscard]] constexpr auto size(base_type base, node_base_type nodes, typename std::iterator_traits<node_base_type>::difference_type root) noexcept
+	{
+		auto n = typename std::iterator_traits<base_type>::difference_type{};
+		for (auto x = detail::b_tree_node<tree_type, node_base_type>{ nodes, begin<tree_type>(base, nodes, root).leaf }; x; x = x.next())
+			n += x.size();
+		return n;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator node_base_type, typename less_type>
+	[[nodiscard]] constexpr auto validate(base_type first, base_type last, node_base_type nodes_first, node_base_type nodes_last, typename std::iterator_traits<node_base_type>::difference_type root, less_type less) noexcept
+	{
+		using node_type = detail::b_tree_node<tree_type, node_base_type>;
+		return detail::do_validate(first, std::distance(first, last), node_type{ nodes_first, root }, std::distance(nodes_first, nodes_last), less);
+	}
+
+	template <typename tree_type, std::ranges::random_access_range rng, std::ranges::random_access_range node_rng, typename less_type>
+	[[nodiscard]] constexpr auto validate(rng r, node_rng nodes, typename std::iterator_traits<std::ranges::iterator_t<node_rng>>::difference_type root, less_type less) noexcept
+	{
+		return validate<tree_type>(std::begin(r), std::end(r), std::begin(nodes), std::end(nodes), root, less);
+	}
+}
+
+#endif
+#endif
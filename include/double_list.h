@@ -3,6 +3,7 @@
 #if defined(C133C1CF8A2F41C59893CB2734D85167)
 
 #include "intrusive.h"
+#include <array>
 #include <iterator>
 #include <limits>
 
@@ -164,6 +165,17 @@ namespace double_list {
 
 			return true;
 		}
+
+		// Checks x against its neighbours. x passes if it is neither head nor linked to from its prev, since it isn't part of the list then.
+		template <typename list_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_validate_node(double_list_node<list_type, base_type> x, double_list_node<list_type, base_type> head, typename std::iterator_traits<base_type>::difference_type extent) noexcept
+		{
+			if (not detail::check_index(x, extent))
+				return false;
+			if (x == head ? bool(x.prev()) : not detail::check_index(x.prev(), extent) or x.prev().next() not_eq x)
+				return x not_eq head;
+			return not x.next() or (detail::check_index(x.next(), extent) and detail::check_link(x.next(), x));
+		}
 	}
 
 	template <typename list_type, std::random_access_iterator base_type>
@@ -359,6 +371,26 @@ namespace double_list {
 		return std::distance(begin<list_type>(base, root), end<list_type>(base));
 	}
 
+	// Writes the links of the list from head to out in order and returns out.
+	template <typename list_type, std::random_access_iterator base_type, typename out_type>
+	constexpr auto flatten(base_type base, typename std::iterator_traits<base_type>::difference_type head, out_type out) noexcept
+	{
+		for (auto x = detail::double_list_node<list_type, base_type>{ base, head }; x; x = x.next())
+			*out++ = x.link;
+		return out;
+	}
+
+	// Also writes project(element) of every element to values in the same order, and returns both output iterators.
+	template <typename list_type, std::random_access_iterator base_type, typename out_type, typename value_out, typename project_type>
+	constexpr auto flatten(base_type base, typename std::iterator_traits<base_type>::difference_type head, out_type out, value_out values, project_type project) noexcept
+	{
+		for (auto x = detail::double_list_node<list_type, base_type>{ base, head }; x; x = x.next()) {
+			*out++ = x.link;
+			*values++ = project(base[x.link - 1]);
+		}
+		return std::pair{ out, values };
+	}
+
 	template <typename list_type, std::random_access_iterator base_type>
 	[[nodiscard]] constexpr auto node_swap(typename std::iterator_traits<base_type>::difference_type head, typename std::iterator_traits<base_type>::difference_type tail, forward_iter<list_type, base_type> a, forward_iter<list_type, base_type> b) noexcept
 	{
@@ -387,6 +419,41 @@ namespace double_list {
 		using node_type = detail::double_list_node<list_type, std::ranges::iterator_t<rng>>;
 		return detail::do_validate(node_type{ std::begin(r), head }, std::distance(std::begin(r), std::end(r)));
 	}
+
+	/* Checks the nodes at [first_link, last_link) and head against their neighbours, rather than the whole list. If the list was valid before some slots
+	 * changed, as after patch::apply_patch, it is valid after them when the links cover the changed slots and their neighbours from before the change.
+	*/
+	template <typename list_type, std::random_access_iterator base_type, std::input_iterator link_iter>
+	[[nodiscard]] constexpr auto validate_nodes(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type head, link_iter first_link, link_iter last_link) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::double_list_node<list_type, base_type>;
+		if (head and not detail::do_validate_node(node_type{ first, head }, node_type{ first, head }, std::distance(first, last)))
+			return false;
+		for (; first_link not_eq last_link; ++first_link)
+			if (not detail::do_validate_node(node_type{ first, difference_type(*first_link) }, node_type{ first, head }, std::distance(first, last)))
+				return false;
+		return true;
+	}
+
+	/* Writes the next and prev of the nodes at [first_link, last_link) to out and returns it, to be passed to validate_nodes along with the links.
+	 * Links outside [first, last) are skipped.
+	*/
+	template <typename list_type, std::random_access_iterator base_type, std::input_iterator link_iter, typename out_type>
+	constexpr auto neighbours(base_type first, base_type last, link_iter first_link, link_iter last_link, out_type out) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::double_list_node<list_type, base_type>;
+		for (; first_link not_eq last_link; ++first_link) {
+			auto x = node_type{ first, difference_type(*first_link) };
+			if (not detail::check_index(x, std::distance(first, last)))
+				continue;
+			for (auto y : std::array{ x.next(), x.prev() })
+				if (y)
+					*out++ = difference_type(y);
+		}
+		return out;
+	}
 }
 
 #endif
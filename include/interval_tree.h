@@ -0,0 +1,102 @@
+#if not defined(B2C94F6E1D3A4A0C8E57F13A6D9B20C4)
+#define B2C94F6E1D3A4A0C8E57F13A6D9B20C4
+#if defined(B2C94F6E1D3A4A0C8E57F13A6D9B20C4)
+
+#include "red_black_tree.h"
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+/* Half open intervals [start, end) kept in a red_black_tree keyed by start, where every node also holds the largest end in its subtree. interval_type declares
+ * the link, color and key types of a red_black_tree tree_type, an end_type for the end of each interval and a max_end_type for the largest end, and
+ * interval_tree::tree_type<interval_type> is the tree_type to insert and erase with through red_black_tree, which keeps the largest ends up to date as it
+ * would any aggregate. Ends are ordered by < when they are combined, and the less of the queries has to order starts, ends and the query bounds the same way.
+*/
+namespace interval_tree {
+	template <typename interval_type>
+	struct tree_type : interval_type
+	{
+		using end_type = typename interval_type::end_type;
+		using aggregate_type = typename interval_type::max_end_type;
+
+		[[nodiscard]] static constexpr auto identity() noexcept
+		{
+			if constexpr (std::is_enum_v<end_type>)
+				return end_type(std::numeric_limits<std::underlying_type_t<end_type>>::lowest());
+			else
+				return std::numeric_limits<end_type>::lowest();
+		}
+		[[nodiscard]] static constexpr auto lift(auto&& element) noexcept { return end_type(intrusive::_get<end_type>(element)); }
+		[[nodiscard]] static constexpr auto combine(const end_type& a, const end_type& b) noexcept { return a < b ? b : a; }
+	};
+
+	namespace detail {
+		template <typename interval_type, std::random_access_iterator base_type>
+		using node_type = red_black_tree::detail::red_black_tree_node<tree_type<interval_type>, base_type>;
+
+		/* Calls f with every node of the subtree at x whose interval starts before hi and ends after lo, in order of their starts. Subtrees whose largest end
+		 * isn't after lo are skipped, and so are right subtrees once a start isn't before hi, so every node visited is either reported or on one of the two
+		 * paths bounding the result.
+		*/
+		template <typename interval_type, std::random_access_iterator base_type, typename lo_type, typename starts_before_type, typename less_type, typename function_type>
+		constexpr auto do_for_each(node_type<interval_type, base_type> x, const lo_type& lo, starts_before_type& starts_before, less_type& less, function_type& f) -> void
+		{
+			while (x and red_black_tree::detail::before(less, lo, x.aggregate())) {
+				detail::do_for_each(x.left(), lo, starts_before, less, f);
+				if (not starts_before(x.key()))
+					return;
+				if (red_black_tree::detail::before(less, lo, x.lift()))
+					f(x);
+				x = x.right();
+			}
+		}
+
+		// The first node found whose interval starts before hi and ends after lo, descending left whenever the left subtree ends after lo.
+		template <typename interval_type, std::random_access_iterator base_type, typename lo_type, typename starts_before_type, typename less_type>
+		[[nodiscard]] constexpr auto do_find_any(node_type<interval_type, base_type> x, const lo_type& lo, starts_before_type& starts_before, less_type& less) noexcept
+		{
+			while (x and not (starts_before(x.key()) and red_black_tree::detail::before(less, lo, x.lift())))
+				x = x.left() and red_black_tree::detail::before(less, lo, x.left().aggregate()) ? x.left() : x.right();
+			return x;
+		}
+	}
+
+	// Returns the largest end of the intervals in the tree rooted at root, or the lowest end_type if it is empty.
+	template <typename interval_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto max_end(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		return detail::node_type<interval_type, base_type>{ base, root }.aggregate();
+	}
+
+	// Returns an iterator to some interval that overlaps [lo, hi), or end, in O(log n).
+	template <typename interval_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto find_any_overlap(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& lo, const V& hi, less_type less) noexcept
+	{
+		auto starts_before = [&](const auto& start) { return red_black_tree::detail::before(less, start, hi); };
+		auto x = detail::do_find_any(detail::node_type<interval_type, base_type>{ base, root }, lo, starts_before, less);
+		return red_black_tree::forward_iter<tree_type<interval_type>, base_type>{ base, x.root };
+	}
+
+	// Calls f with an iterator to every interval that overlaps [lo, hi) in order of their starts, in O(log n + k) for k intervals.
+	template <typename interval_type, std::random_access_iterator base_type, typename V, typename less_type, typename function_type>
+	constexpr auto for_each_overlap(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& lo, const V& hi, less_type less, function_type f)
+	{
+		auto starts_before = [&](const auto& start) { return red_black_tree::detail::before(less, start, hi); };
+		auto report = [&](detail::node_type<interval_type, base_type> x) { f(red_black_tree::forward_iter<tree_type<interval_type>, base_type>{ base, x.root }); };
+		detail::do_for_each(detail::node_type<interval_type, base_type>{ base, root }, lo, starts_before, less, report);
+		return f;
+	}
+
+	// Calls f with an iterator to every interval that contains point in order of their starts, in O(log n + k) for k intervals.
+	template <typename interval_type, std::random_access_iterator base_type, typename V, typename less_type, typename function_type>
+	constexpr auto stab(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& point, less_type less, function_type f)
+	{
+		auto starts_before = [&](const auto& start) { return not red_black_tree::detail::before(less, point, start); };
+		auto report = [&](detail::node_type<interval_type, base_type> x) { f(red_black_tree::forward_iter<tree_type<interval_type>, base_type>{ base, x.root }); };
+		detail::do_for_each(detail::node_type<interval_type, base_type>{ base, root }, point, starts_before, less, report);
+		return f;
+	}
+}
+
+#endif
+#endif
@@ -2,7 +2,14 @@
 #define A8E14AE30B8745A7846C112EB15E0FCD
 #if defined(A8E14AE30B8745A7846C112EB15E0FCD)
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <compare>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -60,8 +67,150 @@ namespace intrusive {
 
 		template <typename T, typename U>
 		concept has_get = usr_get<T, U> or std_get<T, U> or mem_get<T, U>;
+
+		// Reverses the bytes of v, through the builtin where there is one and otherwise unrolled so compilers can recognize it as a byte swap.
+		template <std::unsigned_integral U>
+		[[nodiscard]] constexpr auto byteswap(U v) noexcept
+		{
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_bswap64)
+			if constexpr (sizeof(U) == 8)
+				return U(__builtin_bswap64(v));
+			if constexpr (sizeof(U) == 4)
+				return U(__builtin_bswap32(v));
+			if constexpr (sizeof(U) == 2)
+				return U(__builtin_bswap16(v));
+#endif
+#endif
+			return [v]<std::size_t... i>(std::index_sequence<i...>) { return U((U(U(U(v >> (i * CHAR_BIT)) & U(UCHAR_MAX)) << ((sizeof(U) - 1 - i) * CHAR_BIT)) | ...)); }(std::make_index_sequence<sizeof(U)>{});
+		}
+
+		// The narrowest unsigned type of at least width bytes.
+		template <std::size_t width>
+		using unsigned_for = std::conditional_t<width <= 1, std::uint8_t, std::conditional_t<width <= 2, std::uint16_t, std::conditional_t<width <= 4, std::uint32_t, std::uint64_t>>>;
+
+		/* The width bytes at p read as the first bytes of a native U whose others are zero, in power of two pieces from offset on, each of which compilers turn
+		 * into a single load.
+		*/
+		template <std::unsigned_integral U, std::size_t width, std::size_t offset = 0>
+		[[nodiscard]] constexpr auto load(const unsigned char* p) noexcept -> U
+		{
+			if constexpr (offset == width)
+				return U{};
+			else {
+				constexpr auto size = std::bit_floor(width - offset);
+				constexpr auto at = std::endian::native == std::endian::little ? offset : sizeof(U) - offset - size;
+				const auto piece = [p]<std::size_t... i>(std::index_sequence<i...>) { return std::bit_cast<unsigned_for<size>>(std::array<unsigned char, size>{ p[offset + i]... }); }(std::make_index_sequence<size>{});
+				return U(U(U(piece) << (at * CHAR_BIT)) | detail::load<U, width, offset + size>(p));
+			}
+		}
 	}
 
+	/* A field holding a T in width bytes, sizeof(T) by default, of the given byte order with an alignment of 1, so it reads the same on any host.
+	 * Explicitly converts to and from integers and enums, which makes it usable as a link, color, count or key type, and compares by value. tag makes
+	 * fields with the same representation distinct types, since fields are found by type. Reads and writes are a plain load or store on a host of the same
+	 * byte order, and a load or store and a byte swap on one of the other. A narrower width keeps the low bytes of the value, sign extended on the way
+	 * back for a signed T, so a 3, 5 or 6 byte link costs a second narrow load and a shift, with no branches, over one of 4 or 8.
+	*/
+	template <typename tag, std::integral T, std::endian order, std::size_t width = sizeof(T)>
+	requires (0 < width and width <= sizeof(T))
+	struct endian_int final
+	{
+		using value_type = T;
+		static_assert(std::endian::native == std::endian::little or std::endian::native == std::endian::big);
+
+		unsigned char bytes[width];
+
+		endian_int() = default;
+		template <typename I>
+		requires std::integral<I> or std::is_enum_v<I>
+		explicit constexpr endian_int(I value) noexcept : bytes{}
+		{
+			using U = std::make_unsigned_t<T>;
+			const auto v = U(T(value));
+			const auto b = std::bit_cast<std::array<unsigned char, sizeof(T)>>(order == std::endian::native ? v : detail::byteswap(v));
+			std::copy_n(b.begin() + (order == std::endian::big ? sizeof(T) - width : 0), width, bytes);
+		}
+		[[nodiscard]] constexpr auto value() const noexcept
+		{
+			using U = std::make_unsigned_t<T>;
+			constexpr auto shift = (sizeof(T) - width) * CHAR_BIT;
+			auto v = detail::load<U, width>(bytes);
+			if constexpr (order not_eq std::endian::native)
+				v = detail::byteswap(v);
+			// The value now sits in the low bytes of v for a little endian field and the high bytes for a big endian one.
+			if constexpr (order == std::endian::big)
+				return T(T(v) >> shift);
+			else if constexpr (std::signed_integral<T>)
+				return T(T(U(v << shift)) >> shift);
+			else
+				return T(v);
+		}
+		template <typename I>
+		requires std::integral<I> or std::is_enum_v<I>
+		[[nodiscard]] explicit constexpr operator I() const noexcept { return I(value()); }
+		[[nodiscard]] friend constexpr auto operator==(const endian_int& a, const endian_int& b) noexcept { return a.value() == b.value(); }
+		[[nodiscard]] friend constexpr auto operator<=>(const endian_int& a, const endian_int& b) noexcept { return a.value() <=> b.value(); }
+	};
+
+	template <typename tag>
+	using le_u16_link = endian_int<tag, std::uint16_t, std::endian::little>;
+	template <typename tag>
+	using le_u32_link = endian_int<tag, std::uint32_t, std::endian::little>;
+	template <typename tag>
+	using le_u64_link = endian_int<tag, std::uint64_t, std::endian::little>;
+	// Links for ranges of up to 16M, 1T and 256T nodes, between the standard widths.
+	template <typename tag>
+	using le_u24_link = endian_int<tag, std::uint32_t, std::endian::little, 3>;
+	template <typename tag>
+	using le_u40_link = endian_int<tag, std::uint64_t, std::endian::little, 5>;
+	template <typename tag>
+	using le_u48_link = endian_int<tag, std::uint64_t, std::endian::little, 6>;
+	template <typename tag>
+	using be_u16_link = endian_int<tag, std::uint16_t, std::endian::big>;
+	template <typename tag>
+	using be_u32_link = endian_int<tag, std::uint32_t, std::endian::big>;
+	template <typename tag>
+	using be_u64_link = endian_int<tag, std::uint64_t, std::endian::big>;
+	template <typename tag>
+	using be_u24_link = endian_int<tag, std::uint32_t, std::endian::big, 3>;
+	template <typename tag>
+	using be_u40_link = endian_int<tag, std::uint64_t, std::endian::big, 5>;
+	template <typename tag>
+	using be_u48_link = endian_int<tag, std::uint64_t, std::endian::big, 6>;
+	// One byte holds a color in either byte order.
+	template <typename tag>
+	using color_byte = endian_int<tag, std::uint8_t, std::endian::little>;
+	template <std::integral T, typename tag = T>
+	using le_key = endian_int<tag, T, std::endian::little>;
+	template <std::integral T, typename tag = T>
+	using be_key = endian_int<tag, T, std::endian::big>;
+
+	namespace detail {
+		// The fewest bytes that hold every link of a range of max_size nodes, 1 to max_size with 0 for null.
+		[[nodiscard]] consteval auto link_width(std::uint64_t max_size) noexcept
+		{
+			auto width = std::size_t{ 1 };
+			while (width < sizeof(max_size) and max_size >> (width * CHAR_BIT))
+				++width;
+			return width;
+		}
+
+	}
+
+	/* The narrowest link type for a range of up to max_size nodes, picking among 1 to 8 bytes so each link is as small as the capacity allows, such as 3
+	 * bytes instead of 4 up to 16M nodes or 5 instead of 8 up to 1T.
+	*/
+	template <std::uint64_t max_size, typename tag, std::endian order = std::endian::little>
+	using link_for_t = endian_int<tag, detail::unsigned_for<detail::link_width(max_size)>, order, detail::link_width(max_size)>;
+
+	/* Whether the bytes of a T mean the same on every host, given its fields are all byte sized like endian_int: it has to be trivially copyable with no
+	 * padding and an alignment of 1, which no field with a wider native integer in it has. Checking nodes with a static_assert keeps an image portable as
+	 * the node type changes. A packed struct of native integers passes too, so those are up to the reader.
+	*/
+	template <typename T>
+	concept portable_layout = std::is_trivially_copyable_v<T> and std::is_standard_layout_v<T> and std::has_unique_object_representations_v<T> and alignof(T) == 1;
+
 	template <typename T, typename U>
 	requires detail::has_get<T, U>
 	[[nodiscard]] constexpr decltype(auto) _get(const U& u) noexcept
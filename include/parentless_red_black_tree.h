@@ -0,0 +1,628 @@
+#if not defined(C9D00A57CC2B443AAEEE1858C4287AFD)
+#define C9D00A57CC2B443AAEEE1858C4287AFD
+#if defined(C9D00A57CC2B443AAEEE1858C4287AFD)
+
+#include "intrusive.h"
+#include <array>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+
+/* A red black tree whose nodes have no parent link. tree_type provides left_type, right_type, key_type and color_type like red_black_tree, but no
+ * parent_type, so each node is one link smaller and rotations store one link less per node moved. Operations that need to climb the tree instead
+ * keep the ancestors of the current node on a fixed size stack, which the iterators carry with them. The stack holds 2 * digits of difference_type
+ * links, the most a red black tree of max_size nodes can need, so iterators are large and are better advanced in place than copied around.
+*/
+namespace parentless_red_black_tree {
+	namespace detail {
+		enum class color : bool { red, black };
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		struct parentless_node final
+		{
+			base_type base;
+			using color_type = typename tree_type::color_type;
+			using left_type = typename tree_type::left_type;
+			using right_type = typename tree_type::right_type;
+			using key_type = typename tree_type::key_type;
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+
+			difference_type root;
+			[[nodiscard]] constexpr auto left() const noexcept { return parentless_node{ base, difference_type(left_type(intrusive::_get<left_type>(base[root - 1]))) }; }
+			[[nodiscard]] constexpr auto right() const noexcept { return parentless_node{ base, difference_type(right_type(intrusive::_get<right_type>(base[root - 1]))) }; }
+			[[nodiscard]] constexpr auto color() const noexcept { return root ? detail::color(color_type(intrusive::_get<color_type>(base[root - 1]))) : color::black; }
+
+			constexpr auto left(const parentless_node& left) const noexcept { intrusive::_get<left_type>(base[root - 1]) = left_type(left.root); }
+			constexpr auto right(const parentless_node& right) const noexcept { intrusive::_get<right_type>(base[root - 1]) = right_type(right.root); }
+			constexpr auto color(enum color color) const noexcept { intrusive::_get<color_type>(base[root - 1]) = color_type(color); }
+			[[nodiscard]] constexpr decltype(auto) key() const noexcept
+			{
+				if constexpr (std::is_same_v<key_type, std::remove_cvref_t<decltype(intrusive::_get<key_type>(*std::declval<base_type>()))>> )
+					return intrusive::_get<key_type>(base[root - 1]);
+				else
+					return key_type(intrusive::_get<key_type>(base[root - 1]));
+			}
+			[[nodiscard]] constexpr auto operator==(const parentless_node& other) const noexcept { return root == other.root; }
+			[[nodiscard]] constexpr auto operator!=(const parentless_node& other) const noexcept { return root not_eq other.root; }
+			[[nodiscard]] explicit constexpr operator bool() const noexcept { return bool(root); }
+			[[nodiscard]] explicit constexpr operator difference_type() const noexcept { return root; }
+		};
+
+		template <std::random_access_iterator base_type>
+		inline constexpr auto max_height = 2 * std::numeric_limits<typename std::iterator_traits<base_type>::difference_type>::digits;
+
+		// The nodes from the root down to the current node, which is on top. An empty path is the end position.
+		template <std::random_access_iterator base_type>
+		struct path final
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+
+			std::array<difference_type, max_height<base_type>> links;
+			difference_type depth;
+			constexpr auto push(difference_type link) noexcept { links[depth++] = link; }
+			constexpr auto pop() noexcept { return links[--depth]; }
+			[[nodiscard]] constexpr auto top() const noexcept { return depth ? links[depth - 1] : difference_type{}; }
+			[[nodiscard]] constexpr auto below_top() const noexcept { return depth > 1 ? links[depth - 2] : difference_type{}; }
+		};
+
+		// Rotations return the node that took x's place. the caller links it into x's old parent.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto left_rotate(const parentless_node<tree_type, base_type> x) noexcept
+		{
+			const auto y = x.right();
+			x.right(y.left());
+			y.left(x);
+			return y;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto right_rotate(const parentless_node<tree_type, base_type> x) noexcept
+		{
+			const auto y = x.left();
+			x.left(y.right());
+			y.right(x);
+			return y;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto replace_child(parentless_node<tree_type, base_type> root, const parentless_node<tree_type, base_type> parent, const parentless_node<tree_type, base_type> old_child, const parentless_node<tree_type, base_type> new_child) noexcept
+		{
+			if (not parent)
+				root = new_child;
+			else if (parent.left() == old_child)
+				parent.left(new_child);
+			else
+				parent.right(new_child);
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto push_min(path<base_type>& p, parentless_node<tree_type, base_type> x) noexcept
+		{
+			for (; x; x = x.left())
+				p.push(x.root);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto push_max(path<base_type>& p, parentless_node<tree_type, base_type> x) noexcept
+		{
+			for (; x; x = x.right())
+				p.push(x.root);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto successor(base_type base, path<base_type>& p) noexcept
+		{
+			using node_type = parentless_node<tree_type, base_type>;
+			if (auto x = node_type{ base, p.top() }.right())
+				return detail::push_min(p, x);
+			auto child = p.pop();
+			while (p.depth and node_type{ base, p.top() }.right().root == child)
+				child = p.pop();
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto predecessor(base_type base, path<base_type>& p) noexcept
+		{
+			using node_type = parentless_node<tree_type, base_type>;
+			if (auto x = node_type{ base, p.top() }.left())
+				return detail::push_max(p, x);
+			auto child = p.pop();
+			while (p.depth and node_type{ base, p.top() }.left().root == child)
+				child = p.pop();
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto insert_fixup(parentless_node<tree_type, base_type> root, path<base_type>& p, parentless_node<tree_type, base_type> z) noexcept
+		{
+			using node_type = parentless_node<tree_type, base_type>;
+			while (color::red == node_type{ z.base, p.top() }.color()) {
+				auto parent = node_type{ z.base, p.pop() };
+				const auto grandparent = node_type{ z.base, p.pop() };
+				const auto left = parent == grandparent.left();
+				const auto uncle = left ? grandparent.right() : grandparent.left();
+				if (color::red == uncle.color()) {
+					parent.color(color::black);
+					uncle.color(color::black);
+					grandparent.color(color::red);
+					z = grandparent;
+					continue;
+				}
+				if (z == (left ? parent.right() : parent.left())) {
+					if (left)
+						grandparent.left(detail::left_rotate(parent));
+					else
+						grandparent.right(detail::right_rotate(parent));
+					std::swap(z, parent);
+				}
+				parent.color(color::black);
+				grandparent.color(color::red);
+				root = detail::replace_child(root, node_type{ z.base, p.top() }, grandparent, left ? detail::right_rotate(grandparent) : detail::left_rotate(grandparent));
+				break;
+			}
+			root.color(color::black);
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_insert(parentless_node<tree_type, base_type> root, const parentless_node<tree_type, base_type> z, less_type less) noexcept
+		{
+			auto p = path<base_type>{};
+			auto left = false;
+			for (auto x = root; x; x = left ? x.left() : x.right()) {
+				p.push(x.root);
+				left = less(z.key(), x.key());
+			}
+			z.left({});
+			z.right({});
+			z.color(color::red);
+			if (not p.depth)
+				root = z;
+			else if (left)
+				parentless_node<tree_type, base_type>{ z.base, p.top() }.left(z);
+			else
+				parentless_node<tree_type, base_type>{ z.base, p.top() }.right(z);
+			return detail::insert_fixup(root, p, z);
+		}
+
+		// p holds the ancestors of x, whose subtree is one black node short.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto delete_fixup(parentless_node<tree_type, base_type> root, path<base_type>& p, parentless_node<tree_type, base_type> x) noexcept
+		{
+			using node_type = parentless_node<tree_type, base_type>;
+			while (x not_eq root and color::black == x.color()) {
+				const auto xp = node_type{ root.base, p.top() };
+				const auto left = xp.left() == x;
+				auto w = left ? xp.right() : xp.left();
+				if (color::red == w.color()) {
+					w.color(color::black);
+					xp.color(color::red);
+					root = detail::replace_child(root, node_type{ root.base, p.below_top() }, xp, left ? detail::left_rotate(xp) : detail::right_rotate(xp));
+					p.links[p.depth - 1] = w.root;
+					p.push(xp.root);
+					w = left ? xp.right() : xp.left();
+				}
+				if (color::black == w.left().color() and color::black == w.right().color()) {
+					w.color(color::red);
+					x = xp;
+					p.pop();
+				} else {
+					if (color::black == (left ? w.right() : w.left()).color()) {
+						(left ? w.left() : w.right()).color(color::black);
+						w.color(color::red);
+						if (left)
+							xp.right(detail::right_rotate(w));
+						else
+							xp.left(detail::left_rotate(w));
+						w = left ? xp.right() : xp.left();
+					}
+					w.color(xp.color());
+					xp.color(color::black);
+					(left ? w.right() : w.left()).color(color::black);
+					p.pop();
+					root = detail::replace_child(root, node_type{ root.base, p.top() }, xp, left ? detail::left_rotate(xp) : detail::right_rotate(xp));
+					x = root;
+				}
+			}
+			if (x)
+				x.color(color::black);
+			return root;
+		}
+
+		// p is the path to the node to erase and is consumed.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_erase(parentless_node<tree_type, base_type> root, path<base_type>& p) noexcept
+		{
+			using node_type = parentless_node<tree_type, base_type>;
+			const auto z = node_type{ root.base, p.top() };
+			const auto z_depth = p.depth;
+			auto y = z;
+			if (z.left() and z.right()) {
+				detail::push_min(p, z.right());
+				y = node_type{ root.base, p.top() };
+			}
+			const auto x = y.left() ? y.left() : y.right();
+			const auto removed_color = y.color();
+			p.pop();
+			root = detail::replace_child(root, node_type{ root.base, p.top() }, y, x);
+			if (y not_eq z) {
+				y.left(z.left());
+				y.right(z.right());
+				y.color(z.color());
+				root = detail::replace_child(root, node_type{ root.base, z_depth > 1 ? p.links[z_depth - 2] : 0 }, z, y);
+				p.links[z_depth - 1] = y.root;
+			}
+			if (color::black == removed_color)
+				root = detail::delete_fixup(root, p, x);
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_lower_bound(parentless_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto p = path<base_type>{};
+			auto depth = p.depth;
+			for (; x; ) {
+				p.push(x.root);
+				if (not less(x.key(), value)) {
+					depth = p.depth;
+					x = x.left();
+				} else
+					x = x.right();
+			}
+			p.depth = depth;
+			return p;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_upper_bound(parentless_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto p = path<base_type>{};
+			auto depth = p.depth;
+			for (; x; ) {
+				p.push(x.root);
+				if (less(value, x.key())) {
+					depth = p.depth;
+					x = x.left();
+				} else
+					x = x.right();
+			}
+			p.depth = depth;
+			return p;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_find(parentless_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto p = detail::do_lower_bound(x, value, less);
+			if (p.depth and less(value, parentless_node<tree_type, base_type>{ x.base, p.top() }.key()))
+				p.depth = 0;
+			return p;
+		}
+
+		// Relinks dst into the place of the node on top of p, which is not in the tree afterwards.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_node_relink(parentless_node<tree_type, base_type> root, const parentless_node<tree_type, base_type> dst, const path<base_type>& p) noexcept
+		{
+			const auto src = parentless_node<tree_type, base_type>{ root.base, p.top() };
+			dst.left(src.left());
+			dst.right(src.right());
+			dst.color(src.color());
+			return detail::replace_child(root, parentless_node<tree_type, base_type>{ root.base, p.below_top() }, src, dst);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_node_swap(parentless_node<tree_type, base_type> root, const path<base_type>& a_path, const path<base_type>& b_path) noexcept
+		{
+			using node_type = parentless_node<tree_type, base_type>;
+			const auto a = node_type{ root.base, a_path.top() };
+			const auto b = node_type{ root.base, b_path.top() };
+			const auto a_parent = node_type{ root.base, a_path.below_top() };
+			const auto b_parent = node_type{ root.base, b_path.below_top() };
+			const auto a_left = a.left();
+			const auto a_right = a.right();
+			const auto b_left = b.left();
+			const auto b_right = b.right();
+			const auto a_is_left = a_parent and a_parent.left() == a;
+			const auto b_is_left = b_parent and b_parent.left() == b;
+
+			if (b_is_left)
+				b_parent.left(a);
+			else if (b_parent)
+				b_parent.right(a);
+			if (a_is_left)
+				a_parent.left(b);
+			else if (a_parent)
+				a_parent.right(b);
+
+			const auto a_color = a.color();
+			a.color(b.color());
+			b.color(a_color);
+
+			a.left(b_left not_eq a ? b_left : b);
+			a.right(b_right not_eq a ? b_right : b);
+			b.left(a_left not_eq b ? a_left : a);
+			b.right(a_right not_eq b ? a_right : a);
+
+			return root == a ? b : root == b ? a : root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto check_index(parentless_node<tree_type, base_type> curr, typename std::iterator_traits<base_type>::difference_type extent) noexcept
+		{
+			using T = typename std::iterator_traits<base_type>::difference_type;
+			return T{} < T(curr) and T(curr) <= extent;
+		}
+
+		/* Returns the black height of the subtree at curr if it is valid and its keys lie between lo and hi. A tree with no parent links can't be checked for
+		 * nodes linked from two places directly, so this bounds the depth and the number of nodes visited by the extent instead, which catches every cycle.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_validate(parentless_node<tree_type, base_type> curr, parentless_node<tree_type, base_type> lo, parentless_node<tree_type, base_type> hi, enum color parent_color, typename std::iterator_traits<base_type>::difference_type depth, typename std::iterator_traits<base_type>::difference_type extent, typename std::iterator_traits<base_type>::difference_type& visited, less_type less) noexcept -> std::optional<typename std::iterator_traits<base_type>::difference_type>
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			if (not curr)
+				return difference_type{};
+			if (depth == max_height<base_type> or ++visited > extent or not detail::check_index(curr, extent))
+				return std::nullopt;
+			if (color::red == parent_color and color::red == curr.color())
+				return std::nullopt;
+			if ((lo and less(curr.key(), lo.key())) or (hi and less(hi.key(), curr.key())))
+				return std::nullopt;
+			auto left = detail::do_validate(curr.left(), lo, curr, curr.color(), depth + 1, extent, visited, less);
+			if (not left)
+				return std::nullopt;
+			auto right = detail::do_validate(curr.right(), curr, hi, curr.color(), depth + 1, extent, visited, less);
+			if (not right or *left not_eq *right)
+				return std::nullopt;
+			return *left + (color::black == curr.color());
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_validate(parentless_node<tree_type, base_type> root, typename std::iterator_traits<base_type>::difference_type extent, less_type less) noexcept
+		{
+			auto visited = decltype(extent){};
+			if (color::red == root.color())
+				return false;
+			return bool(detail::do_validate(root, {}, {}, color::black, {}, extent, visited, less));
+		}
+	}
+
+	/* Implements a forward iterator for an intrusive balanced binary search tree without parent links. It holds the path from the root to its element, so it
+	 * stays valid only while the tree isn't modified other than through it. Like red_black_tree this is a bidirectional iterator except end is not decrementable.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type>
+	struct forward_iter final
+	{
+		using value_type = std::iterator_traits<base_type>::value_type;
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using reference = std::iterator_traits<base_type>::reference;
+		using pointer = std::iterator_traits<base_type>::pointer;
+		using iterator_category = std::forward_iterator_tag;
+
+		base_type base;
+		detail::path<base_type> path;
+		[[nodiscard]] constexpr auto link() const noexcept { return path.top(); }
+		constexpr decltype(auto) operator++() noexcept
+		{
+			detail::successor<tree_type>(base, path);
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator++(int) noexcept { auto copy = *this; ++(*this); return copy; }
+		constexpr decltype(auto) operator--() noexcept
+		{
+			detail::predecessor<tree_type>(base, path);
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator--(int) noexcept { auto copy = *this; --(*this); return copy; }
+		[[nodiscard]] constexpr decltype(auto) operator*() const noexcept { return base[link() - 1]; }
+		[[nodiscard]] constexpr auto operator->() const noexcept { return base + (link() - 1); }
+		[[nodiscard]] constexpr decltype(auto) operator*() noexcept { return base[link() - 1]; }
+		[[nodiscard]] constexpr auto operator->() noexcept { return base + (link() - 1); }
+		template <typename other_base>
+		[[nodiscard]] constexpr auto operator==(const forward_iter<tree_type, other_base>& other) const noexcept { return link() == other.link(); }
+		template <typename other_base>
+		[[nodiscard]] constexpr auto operator!=(const forward_iter<tree_type, other_base>& other) const noexcept { return link() not_eq other.link(); }
+	};
+
+	// Implements reverse iterator. This is the mirror of the forward iterator class with all the same guarentees.
+	template <typename tree_type, std::random_access_iterator base_type>
+	struct reverse_iter final
+	{
+		using value_type = std::iterator_traits<base_type>::value_type;
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using reference = std::iterator_traits<base_type>::reference;
+		using pointer = std::iterator_traits<base_type>::pointer;
+		using iterator_category = std::forward_iterator_tag;
+
+		base_type base;
+		detail::path<base_type> path;
+		[[nodiscard]] constexpr auto link() const noexcept { return path.top(); }
+		constexpr decltype(auto) operator++() noexcept
+		{
+			detail::predecessor<tree_type>(base, path);
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator++(int) noexcept { auto copy = *this; ++(*this); return copy; }
+		constexpr decltype(auto) operator--() noexcept
+		{
+			detail::successor<tree_type>(base, path);
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator--(int) noexcept { auto copy = *this; --(*this); return copy; }
+		[[nodiscard]] constexpr decltype(auto) operator*() const noexcept { return base[link() - 1]; }
+		[[nodiscard]] constexpr auto operator->() const noexcept { return base + (link() - 1); }
+		[[nodiscard]] constexpr decltype(auto) operator*() noexcept { return base[link() - 1]; }
+		[[nodiscard]] constexpr auto operator->() noexcept { return base + (link() - 1); }
+		template <typename other_base>
+		[[nodiscard]] constexpr auto operator==(const reverse_iter<tree_type, other_base>& other) const noexcept { return link() == other.link(); }
+		template <typename other_base>
+		[[nodiscard]] constexpr auto operator!=(const reverse_iter<tree_type, other_base>& other) const noexcept { return link() not_eq other.link(); }
+	};
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto end(base_type base) noexcept
+	{
+		return forward_iter<tree_type, base_type>{ base, {} };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto begin(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		auto it = end<tree_type>(base);
+		detail::push_min(it.path, detail::parentless_node<tree_type, base_type>{ base, root });
+		return it;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto rend(base_type base) noexcept
+	{
+		return reverse_iter<tree_type, base_type>{ base, {} };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto rbegin(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		auto it = rend<tree_type>(base);
+		detail::push_max(it.path, detail::parentless_node<tree_type, base_type>{ base, root });
+		return it;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto upper_bound(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return forward_iter<tree_type, base_type>{ base, detail::do_upper_bound(node_type{ base, root }, value, less) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto lower_bound(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return forward_iter<tree_type, base_type>{ base, detail::do_lower_bound(node_type{ base, root }, value, less) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto find(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return forward_iter<tree_type, base_type>{ base, detail::do_find(node_type{ base, root }, value, less) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto equal_range(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		return std::pair{ lower_bound<tree_type>(base, root, value, less), upper_bound<tree_type>(base, root, value, less) };
+	}
+
+	/* Makes an iterator to the element pointed to by it, which must be in the tree rooted at root. Without parent links its path has to be found by searching
+	 * for its key, then stepping over any elements with an equal key before it.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto make_iterator(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type it, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		auto z = node_type{ base, difference_type(std::distance(base, it) + 1) };
+		auto result = lower_bound<tree_type>(base, root, z.key(), less);
+		while (result.link() and result.link() not_eq z.root)
+			++result;
+		return result;
+	}
+
+	/* Inserts an object pointed to by it into the structure rooted at root in the random access range at base. returns the new root.
+	 * There's no uniqueness guarantee; if you wish the tree to contain unique elements, check before inserting an element.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto insert(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type it, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return difference_type(detail::do_insert(node_type{ base, root }, node_type{ base, difference_type(std::distance(base, it) + 1) }, less));
+	}
+
+	// Erases an element it from the structure rooted at root. returns the new root. it must have been reached from root since the tree was last modified.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto erase(typename std::iterator_traits<base_type>::difference_type root, forward_iter<tree_type, base_type> it) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return difference_type(detail::do_erase(node_type{ it.base, root }, it.path));
+	}
+
+	// Given a node in the tree src, and a node out of the tree dst, relink the tree so dst is in the tree where src was. Src's key must be the correct key for dst's position in the tree.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto node_relink(typename std::iterator_traits<base_type>::difference_type root, base_type dst, const forward_iter<tree_type, base_type>& src) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return difference_type(detail::do_node_relink(node_type{ src.base, root }, node_type{ src.base, difference_type(std::distance(src.base, dst) + 1) }, src.path));
+	}
+
+	// Given two nodes with keys and values already swapped, relink the tree so the indices/colors are swapped. Both iterators are invalidated.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto node_swap(typename std::iterator_traits<base_type>::difference_type root, const forward_iter<tree_type, base_type>& a, const forward_iter<tree_type, base_type>& b) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return difference_type(detail::do_node_swap(node_type{ a.base, root }, a.path, b.path));
+	}
+
+	template <std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto empty(typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		return not root;
+	}
+
+	template <std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto max_size() noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		return difference_type(std::numeric_limits<difference_type>::max() - 1);
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto size(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		auto n = typename std::iterator_traits<base_type>::difference_type{};
+		for (auto it = begin<tree_type>(base, root); it.link(); ++it)
+			++n;
+		return n;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename equiv_type>
+	[[nodiscard]] constexpr auto equal(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type other_base, typename std::iterator_traits<base_type>::difference_type other_root, equiv_type equiv) noexcept
+	{
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		auto it = begin<tree_type>(base, root);
+		auto it2 = begin<tree_type>(other_base, other_root);
+		for (; it.link() and it2.link(); ++it, ++it2)
+			if (not equiv(node_type{ base, it.link() }.key(), node_type{ other_base, it2.link() }.key()))
+				return false;
+		return not it.link() and not it2.link();
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename equiv_type>
+	[[nodiscard]] constexpr auto not_equal(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type other_base, typename std::iterator_traits<base_type>::difference_type other_root, equiv_type equiv) noexcept
+	{
+		return not equal<tree_type>(base, root, other_base, other_root, equiv);
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto validate(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, less_type less) noexcept
+	{
+		using node_type = detail::parentless_node<tree_type, base_type>;
+		return detail::do_validate(node_type{ first, root }, std::distance(first, last), less);
+	}
+
+	template <typename tree_type, std::ranges::random_access_range rng, typename less_type>
+	[[nodiscard]] constexpr auto validate(rng r, typename std::iterator_traits<std::ranges::iterator_t<rng>>::difference_type root, less_type less) noexcept
+	{
+		using node_type = detail::parentless_node<tree_type, std::ranges::iterator_t<rng>>;
+		return detail::do_validate(node_type{ std::begin(r), root }, std::distance(std::begin(r), std::end(r)), less);
+	}
+}
+
+#endif
+#endif
@@ -0,0 +1,75 @@
+#if not defined(D3B6E0A4C81F4F7BA25E96C0D1847F3A)
+#define D3B6E0A4C81F4F7BA25E96C0D1847F3A
+#if defined(D3B6E0A4C81F4F7BA25E96C0D1847F3A)
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/* Delta patches between two images of the same range of nodes, for shipping an index linked structure to a replica that already holds an older image of it.
+ * A patch is the 1 based links of the slots that differ, which are the same links the structures use, and the new objects of those slots in the same order,
+ * plus whatever root, head or tail the sender tracks. Because only changed slots go out, an update of k nodes costs k links and k objects however large the
+ * range is.
+ *
+ * The receiver can check the result without walking the whole structure: collect the neighbours of the patched links from the old image with the neighbours
+ * function of the structure, apply the patch, and pass both sets of links to its validate_nodes, which only looks at those nodes and the paths above them.
+*/
+namespace patch {
+	namespace detail {
+		template <typename T>
+		concept byte_comparable = std::is_trivially_copyable_v<T> and std::has_unique_object_representations_v<T>;
+
+		struct same_bytes final
+		{
+			template <byte_comparable T>
+			[[nodiscard]] constexpr auto operator()(const T& a, const T& b) const noexcept
+			{
+				if (std::is_constant_evaluated())
+					return std::bit_cast<std::array<unsigned char, sizeof(T)>>(a) == std::bit_cast<std::array<unsigned char, sizeof(T)>>(b);
+				return 0 == std::memcmp(std::addressof(a), std::addressof(b), sizeof(T));
+			}
+		};
+	}
+
+	/* Writes the link of every slot of [first, last) that isn't equal to the slot at the same position of other_first to links, and the object of other_first
+	 * to values, and returns both output iterators. So first is the old image and other_first the new one.
+	*/
+	template <std::random_access_iterator base_type, std::random_access_iterator other_type, typename link_out, typename value_out, typename equal_type>
+	constexpr auto make_patch(base_type first, base_type last, other_type other_first, link_out links, value_out values, equal_type equal) noexcept
+	{
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+		for (auto i = difference_type{}; i < std::distance(first, last); ++i)
+			if (not equal(first[i], other_first[i])) {
+				*links++ = i + 1;
+				*values++ = other_first[i];
+			}
+		return std::pair{ links, values };
+	}
+
+	// Compares the object representations of the slots, which have to be trivially copyable without padding.
+	template <std::random_access_iterator base_type, std::random_access_iterator other_type, typename link_out, typename value_out>
+	constexpr auto make_patch(base_type first, base_type last, other_type other_first, link_out links, value_out values) noexcept
+	{
+		return patch::make_patch(first, last, other_first, links, values, detail::same_bytes{});
+	}
+
+	/* Overwrites the slot of [first, last) at each link of [first_link, last_link) with the next object of values, and returns values past the last one used.
+	 * Links outside the range skip their object, and fail validate_nodes afterwards.
+	*/
+	template <std::random_access_iterator base_type, std::input_iterator link_iter, std::input_iterator value_iter>
+	constexpr auto apply_patch(base_type first, base_type last, link_iter first_link, link_iter last_link, value_iter values) noexcept
+	{
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+		for (; first_link not_eq last_link; ++first_link, ++values)
+			if (auto link = difference_type(*first_link); difference_type{} < link and link <= std::distance(first, last))
+				first[link - 1] = *values;
+		return values;
+	}
+}
+
+#endif
+#endif
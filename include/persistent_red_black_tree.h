@@ -0,0 +1,286 @@
+#if not defined(A6E3F8B14D2C4B7E9C05D7A2E1F36B98)
+#define A6E3F8B14D2C4B7E9C05D7A2E1F36B98
+#if defined(A6E3F8B14D2C4B7E9C05D7A2E1F36B98)
+
+#include "parentless_red_black_tree.h"
+#include <iterator>
+#include <utility>
+
+/* Copy on write versions of a parentless_red_black_tree, which share every subtree they have in common. tree_type provides what parentless_red_black_tree
+ * needs and a refcount_type holding the number of links and roots referring to each node. Insert and erase consume the root they are given and return a new
+ * one. Nodes referred to only once belong to that version and change in place, but shared nodes on the way are first copied into a slot taken from alloc,
+ * which returns an iterator to a free slot of the range, so a version kept alive by retain never changes. release drops a root and gives every node no
+ * longer referred to back to free, which takes an iterator to the slot. A node with parent links can't be shared between versions, which is why this
+ * builds on the parentless tree, and the parentless queries, iterators and validate all work on any version.
+ *
+ * Only the slots taken for a change and the counts of the nodes they share are written, so readers of other versions, which never read the count, can run
+ * while a writer changes the tree.
+*/
+namespace persistent_red_black_tree {
+	namespace detail {
+		using parentless_red_black_tree::detail::color;
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		using node_type = parentless_red_black_tree::detail::parentless_node<tree_type, base_type>;
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto refs(const node_type<tree_type, base_type> x) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			using refcount_type = typename tree_type::refcount_type;
+			return difference_type(refcount_type(intrusive::_get<refcount_type>(x.base[x.root - 1])));
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto refs(const node_type<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type n) noexcept
+		{
+			using refcount_type = typename tree_type::refcount_type;
+			intrusive::_get<refcount_type>(x.base[x.root - 1]) = refcount_type(n);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto retain(const node_type<tree_type, base_type> x) noexcept
+		{
+			if (x)
+				detail::refs(x, detail::refs(x) + 1);
+		}
+
+		// Copies x into a slot from alloc. The copy takes over one reference to x, and adds one to each of its children.
+		template <typename tree_type, std::random_access_iterator base_type, typename alloc_type>
+		[[nodiscard]] constexpr auto copy(const node_type<tree_type, base_type> x, alloc_type& alloc) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			const auto it = alloc();
+			*it = x.base[x.root - 1];
+			const auto y = node_type<tree_type, base_type>{ x.base, difference_type(std::distance(x.base, it) + 1) };
+			detail::refs(y, 1);
+			detail::retain(y.left());
+			detail::retain(y.right());
+			detail::refs(x, detail::refs(x) - 1);
+			return y;
+		}
+
+		// Returns x if this version is its only owner, and otherwise a copy of it linked in its place under parent, which this version owns already.
+		template <typename tree_type, std::random_access_iterator base_type, typename alloc_type>
+		[[nodiscard]] constexpr auto own(node_type<tree_type, base_type>& root, const node_type<tree_type, base_type> parent, const node_type<tree_type, base_type> x, alloc_type& alloc) noexcept
+		{
+			if (not x or detail::refs(x) == 1)
+				return x;
+			const auto y = detail::copy(x, alloc);
+			root = parentless_red_black_tree::detail::replace_child(root, parent, x, y);
+			return y;
+		}
+
+		// parentless_red_black_tree::detail::insert_fixup, except an uncle is owned before it is recolored. Every other node it changes is on the path.
+		template <typename tree_type, std::random_access_iterator base_type, typename alloc_type>
+		[[nodiscard]] constexpr auto insert_fixup(node_type<tree_type, base_type> root, parentless_red_black_tree::detail::path<base_type>& p, node_type<tree_type, base_type> z, alloc_type& alloc) noexcept
+		{
+			using parentless_red_black_tree::detail::left_rotate;
+			using parentless_red_black_tree::detail::right_rotate;
+			using node = node_type<tree_type, base_type>;
+			while (color::red == node{ z.base, p.top() }.color()) {
+				auto parent = node{ z.base, p.pop() };
+				const auto grandparent = node{ z.base, p.pop() };
+				const auto left = parent == grandparent.left();
+				const auto uncle = left ? grandparent.right() : grandparent.left();
+				if (color::red == uncle.color()) {
+					parent.color(color::black);
+					detail::own(root, grandparent, uncle, alloc).color(color::black);
+					grandparent.color(color::red);
+					z = grandparent;
+					continue;
+				}
+				if (z == (left ? parent.right() : parent.left())) {
+					if (left)
+						grandparent.left(left_rotate(parent));
+					else
+						grandparent.right(right_rotate(parent));
+					std::swap(z, parent);
+				}
+				parent.color(color::black);
+				grandparent.color(color::red);
+				root = parentless_red_black_tree::detail::replace_child(root, node{ z.base, p.top() }, grandparent, left ? right_rotate(grandparent) : left_rotate(grandparent));
+				break;
+			}
+			root.color(color::black);
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename alloc_type>
+		[[nodiscard]] constexpr auto do_insert(node_type<tree_type, base_type> root, const node_type<tree_type, base_type> z, less_type less, alloc_type& alloc) noexcept
+		{
+			auto p = parentless_red_black_tree::detail::path<base_type>{};
+			auto left = false;
+			for (auto x = detail::own(root, {}, root, alloc); x; x = detail::own(root, x, left ? x.left() : x.right(), alloc)) {
+				p.push(x.root);
+				left = less(z.key(), x.key());
+			}
+			z.left({});
+			z.right({});
+			z.color(color::red);
+			detail::refs(z, 1);
+			if (not p.depth)
+				root = z;
+			else if (left)
+				node_type<tree_type, base_type>{ z.base, p.top() }.left(z);
+			else
+				node_type<tree_type, base_type>{ z.base, p.top() }.right(z);
+			return detail::insert_fixup(root, p, z, alloc);
+		}
+
+		/* parentless_red_black_tree::detail::delete_fixup, except the sibling, and each nephew about to be recolored, are owned first. The nodes rotated are
+		 * all on the path or owned that way.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename alloc_type>
+		[[nodiscard]] constexpr auto delete_fixup(node_type<tree_type, base_type> root, parentless_red_black_tree::detail::path<base_type>& p, node_type<tree_type, base_type> x, alloc_type& alloc) noexcept
+		{
+			using parentless_red_black_tree::detail::left_rotate;
+			using parentless_red_black_tree::detail::right_rotate;
+			using parentless_red_black_tree::detail::replace_child;
+			using node = node_type<tree_type, base_type>;
+			while (x not_eq root and color::black == x.color()) {
+				const auto xp = node{ root.base, p.top() };
+				const auto left = xp.left() == x;
+				auto w = detail::own(root, xp, left ? xp.right() : xp.left(), alloc);
+				if (color::red == w.color()) {
+					w.color(color::black);
+					xp.color(color::red);
+					root = replace_child(root, node{ root.base, p.below_top() }, xp, left ? left_rotate(xp) : right_rotate(xp));
+					p.links[p.depth - 1] = w.root;
+					p.push(xp.root);
+					w = detail::own(root, xp, left ? xp.right() : xp.left(), alloc);
+				}
+				if (color::black == w.left().color() and color::black == w.right().color()) {
+					w.color(color::red);
+					x = xp;
+					p.pop();
+				} else {
+					if (color::black == (left ? w.right() : w.left()).color()) {
+						detail::own(root, w, left ? w.left() : w.right(), alloc).color(color::black);
+						w.color(color::red);
+						if (left)
+							xp.right(right_rotate(w));
+						else
+							xp.left(left_rotate(w));
+						w = left ? xp.right() : xp.left();
+					}
+					w.color(xp.color());
+					xp.color(color::black);
+					detail::own(root, w, left ? w.right() : w.left(), alloc).color(color::black);
+					p.pop();
+					root = replace_child(root, node{ root.base, p.top() }, xp, left ? left_rotate(xp) : right_rotate(xp));
+					x = root;
+				}
+			}
+			if (color::red == x.color())
+				detail::own(root, node{ root.base, p.top() }, x, alloc).color(color::black);
+			return root;
+		}
+
+		// parentless_red_black_tree::detail::do_erase on a path this version owns, which frees the slot erased.
+		template <typename tree_type, std::random_access_iterator base_type, typename alloc_type, typename free_type>
+		[[nodiscard]] constexpr auto do_erase(node_type<tree_type, base_type> root, parentless_red_black_tree::detail::path<base_type>& p, alloc_type& alloc, free_type& free) noexcept
+		{
+			using node = node_type<tree_type, base_type>;
+			for (auto i = decltype(p.depth){}; i < p.depth; ++i)
+				p.links[i] = detail::own(root, node{ root.base, i ? p.links[i - 1] : 0 }, node{ root.base, p.links[i] }, alloc).root;
+			const auto z = node{ root.base, p.top() };
+			const auto z_depth = p.depth;
+			auto y = z;
+			if (z.left() and z.right()) {
+				for (auto x = detail::own(root, z, z.right(), alloc); x; x = detail::own(root, x, x.left(), alloc))
+					p.push(x.root);
+				y = node{ root.base, p.top() };
+			}
+			const auto x = y.left() ? y.left() : y.right();
+			const auto removed_color = y.color();
+			p.pop();
+			root = parentless_red_black_tree::detail::replace_child(root, node{ root.base, p.top() }, y, x);
+			if (y not_eq z) {
+				y.left(z.left());
+				y.right(z.right());
+				y.color(z.color());
+				root = parentless_red_black_tree::detail::replace_child(root, node{ root.base, z_depth > 1 ? p.links[z_depth - 2] : 0 }, z, y);
+				p.links[z_depth - 1] = y.root;
+			}
+			free(root.base + (z.root - 1));
+			if (color::black == removed_color)
+				root = detail::delete_fixup(root, p, x, alloc);
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename free_type>
+		constexpr auto do_release(const node_type<tree_type, base_type> x, free_type& free) noexcept -> void
+		{
+			if (not x)
+				return;
+			if (auto n = detail::refs(x) - 1) {
+				detail::refs(x, n);
+				return;
+			}
+			const auto left = x.left();
+			const auto right = x.right();
+			free(x.base + (x.root - 1));
+			detail::do_release(left, free);
+			detail::do_release(right, free);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_validate_refs(const node_type<tree_type, base_type> x) noexcept -> bool
+		{
+			return not x or (detail::refs(x) > 0 and detail::do_validate_refs(x.left()) and detail::do_validate_refs(x.right()));
+		}
+	}
+
+	// Adds a reference to the version at root, which keeps it unchanged until it is released, and returns root.
+	template <typename tree_type, std::random_access_iterator base_type>
+	constexpr auto retain(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		detail::retain(detail::node_type<tree_type, base_type>{ base, root });
+		return root;
+	}
+
+	// Drops a reference to the version at root, passing every slot nothing refers to anymore to free.
+	template <typename tree_type, std::random_access_iterator base_type, typename free_type>
+	constexpr auto release(base_type base, typename std::iterator_traits<base_type>::difference_type root, free_type free) noexcept
+	{
+		detail::do_release(detail::node_type<tree_type, base_type>{ base, root }, free);
+	}
+
+	/* Inserts the object pointed to by it, which belongs to no version, into the version at root and returns the root of the new version, in place of root.
+	 * O(log n) slots come from alloc when the path is shared.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename alloc_type>
+	[[nodiscard]] constexpr auto insert(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type it, less_type less, alloc_type alloc) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::node_type<tree_type, base_type>;
+		return difference_type(detail::do_insert(node_type{ base, root }, node_type{ base, difference_type(std::distance(base, it) + 1) }, less, alloc));
+	}
+
+	// Erases an element equivalent to value from the version at root and returns the root of the new version, in place of root, or root if there is none.
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type, typename alloc_type, typename free_type>
+	[[nodiscard]] constexpr auto erase(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less, alloc_type alloc, free_type free) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::node_type<tree_type, base_type>;
+		auto p = parentless_red_black_tree::detail::do_find(node_type{ base, root }, value, less);
+		return p.depth ? difference_type(detail::do_erase(node_type{ base, root }, p, alloc, free)) : root;
+	}
+
+	// A version is valid if it is a valid parentless_red_black_tree and every node in it is referred to.
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto validate(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, less_type less) noexcept
+	{
+		return parentless_red_black_tree::validate<tree_type>(first, last, root, less) and detail::do_validate_refs(detail::node_type<tree_type, base_type>{ first, root });
+	}
+
+	template <typename tree_type, std::ranges::random_access_range rng, typename less_type>
+	[[nodiscard]] constexpr auto validate(rng r, typename std::iterator_traits<std::ranges::iterator_t<rng>>::difference_type root, less_type less) noexcept
+	{
+		return validate<tree_type>(std::begin(r), std::end(r), root, less);
+	}
+}
+
+#endif
+#endif
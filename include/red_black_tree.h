@@ -3,14 +3,117 @@
 #if defined(E7A959942F3144E59D41B23FC49920AF)
 
 #include "intrusive.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <compare>
+#include <concepts>
 #include <iterator>
 #include <limits>
 #include <optional>
+#include <tuple>
+#include <utility>
 
 namespace red_black_tree {
+	enum class color_bit { high, low };
+
+	/* Used as tree_type::color_type to keep the color in the highest or lowest bit of the link_type field, which must be one of left_type, right_type or
+	 * parent_type, instead of in a field of its own. The link keeps the other sizeof(link_type) * CHAR_BIT - 1 bits, so max_size<tree_type, base_type> is
+	 * smaller. Links are masked on read and writes keep the color bit as it was.
+	*/
+	template <typename link_type, color_bit bit = color_bit::high>
+	struct packed_color final
+	{
+	};
+
 	namespace detail {
 		enum class color : bool { red, black };
 
+		template <typename tree_type>
+		concept counted = requires { typename tree_type::count_type; };
+
+		/* A tree_type may cache a short, cheaply compared prefix of every key in a prefix_type field, for example the first eight bytes of a string as a big
+		 * endian integer. tree_type::prefix(key) computes it, and a < between two prefixes must imply the keys are ordered the same way.
+		*/
+		template <typename tree_type>
+		concept prefixed = requires { typename tree_type::prefix_type; };
+
+		/* A tree_type may keep a digest of the keys of every subtree in a digest_type field. tree_type::digest(key) hashes a key to an unsigned integer and a
+		 * subtree's digest is the wrapping sum of the hashes of its keys, so it doesn't depend on the shape of the tree and equal sets have equal digests. A key
+		 * that hashes to zero can't be told apart from no key at all, so the hash should avoid it.
+		*/
+		template <typename tree_type>
+		concept digested = requires { typename tree_type::digest_type; };
+
+		template <typename tree_type>
+		using hash_type = std::remove_cvref_t<decltype(tree_type::digest(std::declval<const typename tree_type::key_type&>()))>;
+
+		/* A tree_type may keep an aggregate of every subtree in an aggregate_type field, such as a sum, a minimum or a maximum of some quantity stored in the
+		 * elements. tree_type::lift(element) computes the value of one element, tree_type::combine(a, b) joins the values of adjacent ranges in key order and
+		 * must be associative, and tree_type::identity() is the value of an empty range. Values must be comparable with == for validate.
+		*/
+		template <typename tree_type>
+		concept aggregated = requires { typename tree_type::aggregate_type; };
+
+		template <typename tree_type>
+		using aggregate_value = std::remove_cvref_t<decltype(tree_type::identity())>;
+
+		// Whether a search for value can compare prefixes before falling back to the keys.
+		template <typename tree_type, typename V>
+		concept prefixable = prefixed<tree_type> and requires(const V& value) { { tree_type::prefix(value) } -> std::convertible_to<typename tree_type::prefix_type>; };
+
+		struct no_prefix final
+		{
+		};
+
+		template <typename tree_type, typename V>
+		[[nodiscard]] constexpr auto value_prefix([[maybe_unused]] const V& value) noexcept
+		{
+			if constexpr (prefixable<tree_type, V>)
+				return typename tree_type::prefix_type(tree_type::prefix(value));
+			else
+				return no_prefix{};
+		}
+
+		// A comparator returning an ordering, like std::compare_three_way, instead of whether its first argument is less than its second.
+		template <typename less_type, typename A, typename B>
+		concept three_way = requires(less_type& less, const A& a, const B& b) { { less(a, b) } -> std::convertible_to<std::partial_ordering>; };
+
+		template <typename less_type, typename A, typename B>
+		[[nodiscard]] constexpr auto before(less_type& less, const A& a, const B& b) noexcept
+		{
+			if constexpr (three_way<less_type, A, B>)
+				return less(a, b) < 0;
+			else
+				return bool(less(a, b));
+		}
+
+		template <typename color_type>
+		struct color_packing
+		{
+			using link_type = void;
+		};
+
+		template <typename link, color_bit bit>
+		struct color_packing<packed_color<link, bit>>
+		{
+			using link_type = link;
+			static constexpr auto position = bit;
+		};
+
+		template <typename tree_type, typename link_type>
+		concept packs_color = not std::is_void_v<link_type> and std::same_as<typename color_packing<typename tree_type::color_type>::link_type, link_type>;
+
+		template <typename tree_type, typename difference_type>
+		[[nodiscard]] constexpr auto color_mask() noexcept
+		{
+			using packing = color_packing<typename tree_type::color_type>;
+			using bits_type = std::make_unsigned_t<difference_type>;
+			static_assert(sizeof(typename packing::link_type) <= sizeof(bits_type));
+			return packing::position == color_bit::high ? bits_type(bits_type{1} << (sizeof(typename packing::link_type) * CHAR_BIT - 1)) : bits_type{1};
+		}
+
 		template <typename tree_type, std::random_access_iterator base_type>
 		struct red_black_tree_node final
 		{
@@ -23,15 +126,40 @@ namespace red_black_tree {
 			using difference_type = typename std::iterator_traits<base_type>::difference_type;
 
 			difference_type root;
-			[[nodiscard]] constexpr auto left() const noexcept { return red_black_tree_node{ base, difference_type(left_type(intrusive::_get<left_type>(base[root - 1]))) }; }
-			[[nodiscard]] constexpr auto right() const noexcept { return red_black_tree_node{ base, difference_type(right_type(intrusive::_get<right_type>(base[root - 1]))) }; }
-			[[nodiscard]] constexpr auto parent() const noexcept { return red_black_tree_node{ base, difference_type(parent_type(intrusive::_get<parent_type>(base[root - 1]))) }; }
-			[[nodiscard]] constexpr auto color() const noexcept { return root ? detail::color(color_type(intrusive::_get<color_type>(base[root - 1]))) : color::black; }
-
-			constexpr auto left(const red_black_tree_node& left) const noexcept { intrusive::_get<left_type>(base[root - 1]) = left_type(left.root); }
-			constexpr auto right(const red_black_tree_node& right) const noexcept { intrusive::_get<right_type>(base[root - 1]) = right_type(right.root); }
-			constexpr auto parent(const red_black_tree_node& parent) const noexcept { intrusive::_get<parent_type>(base[root - 1]) = parent_type(parent.root); }
-			constexpr auto color(enum color color) const noexcept { intrusive::_get<color_type>(base[root - 1]) = color_type(color); }
+			[[nodiscard]] constexpr auto left() const noexcept { return red_black_tree_node{ base, link<left_type>() }; }
+			[[nodiscard]] constexpr auto right() const noexcept { return red_black_tree_node{ base, link<right_type>() }; }
+			[[nodiscard]] constexpr auto parent() const noexcept { return red_black_tree_node{ base, link<parent_type>() }; }
+			[[nodiscard]] constexpr auto color() const noexcept
+			{
+				if (not root)
+					return color::black;
+				if constexpr (packs_color<tree_type, typename color_packing<color_type>::link_type>)
+					return detail::color(bool(bits<typename color_packing<color_type>::link_type>() & color_mask<tree_type, difference_type>()));
+				else
+					return detail::color(color_type(intrusive::_get<color_type>(base[root - 1])));
+			}
+
+			constexpr auto left(const red_black_tree_node& left) const noexcept { link<left_type>(left.root); }
+			constexpr auto right(const red_black_tree_node& right) const noexcept { link<right_type>(right.root); }
+			constexpr auto parent(const red_black_tree_node& parent) const noexcept { link<parent_type>(parent.root); }
+			constexpr auto color(enum color color) const noexcept
+			{
+				if constexpr (packs_color<tree_type, typename color_packing<color_type>::link_type>) {
+					using link_type = typename color_packing<color_type>::link_type;
+					constexpr auto mask = color_mask<tree_type, difference_type>();
+					bits<link_type>(color::black == color ? bits<link_type>() | mask : bits<link_type>() & ~mask);
+				} else
+					intrusive::_get<color_type>(base[root - 1]) = color_type(color);
+			}
+			[[nodiscard]] constexpr auto count() const noexcept requires counted<tree_type> { return root ? difference_type(typename tree_type::count_type(intrusive::_get<typename tree_type::count_type>(base[root - 1]))) : difference_type{}; }
+			constexpr auto count(difference_type count) const noexcept requires counted<tree_type> { intrusive::_get<typename tree_type::count_type>(base[root - 1]) = typename tree_type::count_type(count); }
+			[[nodiscard]] constexpr auto digest() const noexcept requires digested<tree_type> { return root ? hash_type<tree_type>(typename tree_type::digest_type(intrusive::_get<typename tree_type::digest_type>(base[root - 1]))) : hash_type<tree_type>{}; }
+			constexpr auto digest(const auto& digest) const noexcept requires digested<tree_type> { intrusive::_get<typename tree_type::digest_type>(base[root - 1]) = typename tree_type::digest_type(digest); }
+			[[nodiscard]] constexpr auto aggregate() const noexcept requires aggregated<tree_type> { return root ? aggregate_value<tree_type>(typename tree_type::aggregate_type(intrusive::_get<typename tree_type::aggregate_type>(base[root - 1]))) : aggregate_value<tree_type>(tree_type::identity()); }
+			constexpr auto aggregate(const auto& aggregate) const noexcept requires aggregated<tree_type> { intrusive::_get<typename tree_type::aggregate_type>(base[root - 1]) = typename tree_type::aggregate_type(aggregate); }
+			[[nodiscard]] constexpr auto lift() const noexcept requires aggregated<tree_type> { return aggregate_value<tree_type>(tree_type::lift(base[root - 1])); }
+			[[nodiscard]] constexpr auto prefix() const noexcept requires prefixed<tree_type> { return typename tree_type::prefix_type(intrusive::_get<typename tree_type::prefix_type>(base[root - 1])); }
+			constexpr auto prefix(const auto& prefix) const noexcept requires prefixed<tree_type> { intrusive::_get<typename tree_type::prefix_type>(base[root - 1]) = typename tree_type::prefix_type(prefix); }
 			[[nodiscard]] constexpr decltype(auto) key() const noexcept
 			{
 				if constexpr (std::is_same_v<key_type, std::remove_cvref_t<decltype(intrusive::_get<key_type>(*std::declval<base_type>()))>> )
@@ -43,8 +171,145 @@ namespace red_black_tree {
 			[[nodiscard]] constexpr auto operator!=(const red_black_tree_node& other) const noexcept { return root not_eq other.root; }
 			[[nodiscard]] explicit constexpr operator bool() const noexcept { return bool(root); }
 			[[nodiscard]] explicit constexpr operator difference_type() const noexcept { return root; }
+
+		private:
+			template <typename link_type>
+			[[nodiscard]] constexpr auto bits() const noexcept { return std::make_unsigned_t<difference_type>(difference_type(link_type(intrusive::_get<link_type>(base[root - 1])))); }
+			template <typename link_type>
+			constexpr auto bits(std::make_unsigned_t<difference_type> bits) const noexcept { intrusive::_get<link_type>(base[root - 1]) = link_type(difference_type(bits)); }
+
+			template <typename link_type>
+			[[nodiscard]] constexpr auto link() const noexcept
+			{
+				if constexpr (not packs_color<tree_type, link_type>)
+					return difference_type(link_type(intrusive::_get<link_type>(base[root - 1])));
+				else if constexpr (color_packing<color_type>::position == color_bit::high)
+					return difference_type(bits<link_type>() & ~color_mask<tree_type, difference_type>());
+				else
+					return difference_type(bits<link_type>() >> 1);
+			}
+			template <typename link_type>
+			constexpr auto link(difference_type link) const noexcept
+			{
+				using bits_type = std::make_unsigned_t<difference_type>;
+				if constexpr (not packs_color<tree_type, link_type>)
+					intrusive::_get<link_type>(base[root - 1]) = link_type(link);
+				else if constexpr (color_packing<color_type>::position == color_bit::high)
+					bits<link_type>(bits_type(link) | (bits<link_type>() & color_mask<tree_type, difference_type>()));
+				else
+					bits<link_type>(bits_type(bits_type(link) << 1) | (bits<link_type>() & bits_type{1}));
+			}
 		};
 
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto subtree_digest(const red_black_tree_node<tree_type, base_type> x) noexcept requires digested<tree_type>
+		{
+			return hash_type<tree_type>(x.left().digest() + hash_type<tree_type>(tree_type::digest(x.key())) + x.right().digest());
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto subtree_aggregate(const red_black_tree_node<tree_type, base_type> x) noexcept requires aggregated<tree_type>
+		{
+			return aggregate_value<tree_type>(tree_type::combine(tree_type::combine(x.left().aggregate(), x.lift()), x.right().aggregate()));
+		}
+
+		// Recomputes the optional bookkeeping fields of x from its children.
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto update(const red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			if constexpr (counted<tree_type>)
+				x.count(x.left().count() + x.right().count() + 1);
+			if constexpr (digested<tree_type>)
+				x.digest(detail::subtree_digest(x));
+			if constexpr (aggregated<tree_type>)
+				x.aggregate(detail::subtree_aggregate(x));
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto update_path(red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			for (; x; x = x.parent())
+				detail::update(x);
+		}
+
+		// Stores the prefix of the key of x, which has to be done before x is compared as part of a tree.
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto update_prefix([[maybe_unused]] const red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			if constexpr (prefixed<tree_type>)
+				x.prefix(typename tree_type::prefix_type(tree_type::prefix(x.key())));
+		}
+
+		// Whether value, whose prefix is p, is ordered before the key of x. Only equal prefixes need the keys to be compared.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename prefix_type, typename less_type>
+		[[nodiscard]] constexpr auto before_node(less_type& less, const V& value, [[maybe_unused]] const prefix_type& p, const red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			if constexpr (not std::is_same_v<prefix_type, no_prefix>) {
+				auto xp = x.prefix();
+				if (p < xp)
+					return true;
+				if (xp < p)
+					return false;
+			}
+			return detail::before(less, value, x.key());
+		}
+
+		// Whether the key of x is ordered before value, whose prefix is p.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename prefix_type, typename less_type>
+		[[nodiscard]] constexpr auto node_before(less_type& less, const red_black_tree_node<tree_type, base_type> x, const V& value, [[maybe_unused]] const prefix_type& p) noexcept
+		{
+			if constexpr (not std::is_same_v<prefix_type, no_prefix>) {
+				auto xp = x.prefix();
+				if (xp < p)
+					return true;
+				if (p < xp)
+					return false;
+			}
+			return detail::before(less, x.key(), value);
+		}
+
+		// dst takes the place of src in a tree, so it takes its bookkeeping except for the prefix, which belongs to the key of dst.
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto copy_bookkeeping(const red_black_tree_node<tree_type, base_type> dst, const red_black_tree_node<tree_type, base_type> src) noexcept
+		{
+			dst.color(src.color());
+			if constexpr (counted<tree_type>)
+				dst.count(src.count());
+			if constexpr (digested<tree_type>)
+				dst.digest(src.digest());
+			if constexpr (aggregated<tree_type>)
+				dst.aggregate(src.aggregate());
+			detail::update_prefix(dst);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto swap_bookkeeping(const red_black_tree_node<tree_type, base_type> a, const red_black_tree_node<tree_type, base_type> b) noexcept
+		{
+			auto a_color = a.color();
+			a.color(b.color());
+			b.color(a_color);
+			if constexpr (counted<tree_type>) {
+				auto a_count = a.count();
+				a.count(b.count());
+				b.count(a_count);
+			}
+			if constexpr (digested<tree_type>) {
+				auto a_digest = a.digest();
+				a.digest(b.digest());
+				b.digest(a_digest);
+			}
+			if constexpr (aggregated<tree_type>) {
+				auto a_aggregate = a.aggregate();
+				a.aggregate(b.aggregate());
+				b.aggregate(a_aggregate);
+			}
+			if constexpr (prefixed<tree_type>) {
+				auto a_prefix = a.prefix();
+				a.prefix(b.prefix());
+				b.prefix(a_prefix);
+			}
+		}
+
 		template <typename tree_type, std::random_access_iterator base_type>
 		[[nodiscard]] constexpr auto left_rotate(red_black_tree_node<tree_type, base_type> root, const red_black_tree_node<tree_type, base_type> x) noexcept
 		{
@@ -61,6 +326,8 @@ namespace red_black_tree {
 				x.parent().right(y);
 			y.left(x);
 			x.parent(y);
+			detail::update(x);
+			detail::update(y);
 			return root;
 		}
 
@@ -80,6 +347,8 @@ namespace red_black_tree {
 				x.parent().right(y);
 			y.right(x);
 			x.parent(y);
+			detail::update(x);
+			detail::update(y);
 			return root;
 		}
 
@@ -126,31 +395,40 @@ namespace red_black_tree {
 			return root;
 		}
 
-		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
-		[[nodiscard]] constexpr auto do_insert(red_black_tree_node<tree_type, base_type> root, red_black_tree_node<tree_type, base_type> z, less_type less) noexcept
+		// Links z as the left or right child of y, which must be free, or as the root if y is null, and rebalances.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_link(red_black_tree_node<tree_type, base_type> root, const red_black_tree_node<tree_type, base_type> y, const red_black_tree_node<tree_type, base_type> z, const bool left) noexcept
 		{
-			auto y = red_black_tree_node<tree_type, base_type>{};
-			auto x = root;
-			while (x) {
-				y = x;
-				if (less(z.key(), x.key()))
-					x = x.left();
-				else
-					x = x.right();
-			}
 			z.color(color::red);
 			z.left(red_black_tree_node<tree_type, base_type>{});
 			z.right(red_black_tree_node<tree_type, base_type>{});
 			z.parent(y);
 			if (not y)
 				root = z;
-			else if (less(z.key(), y.key()))
+			else if (left)
 				y.left(z);
 			else
 				y.right(z);
+			detail::update_path(z);
 			return detail::insert_fixup(root, z);
 		}
 
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_insert(red_black_tree_node<tree_type, base_type> root, red_black_tree_node<tree_type, base_type> z, less_type less) noexcept
+		{
+			auto y = red_black_tree_node<tree_type, base_type>{};
+			auto x = root;
+			auto left = false;
+			detail::update_prefix(z);
+			auto p = detail::value_prefix<tree_type>(z.key());
+			while (x) {
+				y = x;
+				left = detail::before_node(less, z.key(), p, x);
+				x = left ? x.left() : x.right();
+			}
+			return detail::do_link(root, y, z, left);
+		}
+
 		template <typename tree_type, std::random_access_iterator base_type>
 		[[nodiscard]] constexpr auto min(red_black_tree_node<tree_type, base_type> x) noexcept
 		{
@@ -195,6 +473,28 @@ namespace red_black_tree {
 			return y;
 		}
 
+		/* Inserts z next to hint when its key belongs there, checking only hint and its neighbour, and falls back to a full descent otherwise. Like the standard
+		 * containers it prefers the position just before hint. A null hint means the end of the tree.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_insert_hint(red_black_tree_node<tree_type, base_type> root, const red_black_tree_node<tree_type, base_type> hint, const red_black_tree_node<tree_type, base_type> z, less_type less) noexcept
+		{
+			detail::update_prefix(z);
+			if (not root)
+				return detail::do_link(root, hint, z, true);
+			if (hint and not detail::before(less, hint.key(), z.key())) {
+				auto p = detail::predecessor(hint);
+				if (not p or not detail::before(less, z.key(), p.key()))
+					return hint.left() ? detail::do_link(root, p, z, false) : detail::do_link(root, hint, z, true);
+			} else {
+				auto p = hint ? hint : detail::max(root);
+				auto s = hint ? detail::successor(hint) : hint;
+				if ((hint or not detail::before(less, z.key(), p.key())) and (not s or not detail::before(less, s.key(), z.key())))
+					return p.right() ? detail::do_link(root, s, z, true) : detail::do_link(root, p, z, false);
+			}
+			return detail::do_insert(root, z, less);
+		}
+
 		template <typename tree_type, std::random_access_iterator base_type>
 		[[nodiscard]] constexpr auto delete_fixup(red_black_tree_node<tree_type, base_type> root, red_black_tree_node<tree_type, base_type> x, red_black_tree_node<tree_type, base_type> xp) noexcept
 		{
@@ -272,10 +572,12 @@ namespace red_black_tree {
 				in_tree.right().parent(out_of_tree);
 			if (root == in_tree)
 				root = out_of_tree;
-			out_of_tree.color(in_tree.color());
+			detail::copy_bookkeeping(out_of_tree, in_tree);
 			out_of_tree.left(in_tree.left());
 			out_of_tree.right(in_tree.right());
 			out_of_tree.parent(in_tree.parent());
+			if constexpr (digested<tree_type> or aggregated<tree_type>)
+				detail::update_path(out_of_tree);
 			return root;
 		}
 
@@ -309,9 +611,7 @@ namespace red_black_tree {
 			if (a_left)
 				a_left.parent(b);
 
-			auto a_color = a.color();
-			a.color(b.color());
-			b.color(a_color);
+			detail::swap_bookkeeping(a, b);
 
 			a.left(b_left not_eq a ? b_left : b);
 			a.right(b_right not_eq a ? b_right : b);
@@ -343,6 +643,7 @@ namespace red_black_tree {
 			auto removed_parent = node_removed.parent() == target_node ? node_removed : node_removed.parent();
 			if (node_removed not_eq target_node)
 				root = detail::do_node_relink(root, node_removed, target_node);
+			detail::update_path(removed_parent);
 			if (color::black == removed_color)
 				root = detail::delete_fixup(root, removed_child, removed_parent);
 			return root;
@@ -352,8 +653,9 @@ namespace red_black_tree {
 		[[nodiscard]] constexpr auto do_upper_bound(red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
 		{
 			auto z = red_black_tree_node<tree_type, base_type>{};
+			auto p = detail::value_prefix<tree_type>(value);
 			while (x)
-				if (less(value, x.key())) {
+				if (detail::before_node(less, value, p, x)) {
 					z = x;
 					x = x.left();
 				} else
@@ -365,8 +667,9 @@ namespace red_black_tree {
 		[[nodiscard]] constexpr auto do_lower_bound(red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
 		{
 			auto z = red_black_tree_node<tree_type, base_type>{};
+			auto p = detail::value_prefix<tree_type>(value);
 			while (x)
-				if (not less(x.key(), value)) {
+				if (not detail::node_before(less, x, value, p)) {
 					z = x;
 					x = x.left();
 				} else
@@ -374,13 +677,572 @@ namespace red_black_tree {
 			return z;
 		}
 
+		// Orders value, whose prefix is p, against the key of x as a negative, zero or positive number. Unordered values count as greater.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename prefix_type, typename less_type>
+		[[nodiscard]] constexpr auto order_node(less_type& less, const V& value, [[maybe_unused]] const prefix_type& p, const red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			if constexpr (not std::is_same_v<prefix_type, no_prefix>) {
+				auto xp = x.prefix();
+				if (p < xp)
+					return -1;
+				if (xp < p)
+					return 1;
+			}
+			if constexpr (three_way<less_type, V, decltype(x.key())>) {
+				auto c = less(value, x.key());
+				return c < 0 ? -1 : c == 0 ? 0 : 1;
+			} else
+				return detail::before(less, value, x.key()) ? -1 : detail::before(less, x.key(), value) ? 1 : 0;
+		}
+
+		// With a three way comparator the descent stops at the first equivalent node it meets, which need not be the first equivalent one in order.
 		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
 		[[nodiscard]] constexpr auto do_find(red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
 		{
-			x = detail::do_lower_bound(x, value, less);
-			if (x and not less(value, x.key()))
+			auto p = detail::value_prefix<tree_type>(value);
+			if constexpr (three_way<less_type, V, decltype(x.key())>) {
+				while (x) {
+					auto c = detail::order_node(less, value, p, x);
+					if (c < 0)
+						x = x.left();
+					else if (c == 0)
+						return x;
+					else
+						x = x.right();
+				}
 				return x;
-			return red_black_tree_node<tree_type, base_type>{};
+			} else {
+				x = detail::do_lower_bound(x, value, less);
+				if (x and not detail::before_node(less, value, p, x))
+					return x;
+				return red_black_tree_node<tree_type, base_type>{};
+			}
+		}
+
+		// Descends once for both bounds while they share a path and splits into a lower and an upper bound search below the first equivalent node.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_equal_range(red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto upper = red_black_tree_node<tree_type, base_type>{};
+			auto p = detail::value_prefix<tree_type>(value);
+			while (x) {
+				auto c = detail::order_node(less, value, p, x);
+				if (c > 0)
+					x = x.right();
+				else if (c < 0) {
+					upper = x;
+					x = x.left();
+				} else {
+					auto lower = detail::do_lower_bound(x.left(), value, less);
+					auto right_upper = detail::do_upper_bound(x.right(), value, less);
+					return std::pair{ lower ? lower : x, right_upper ? right_upper : upper };
+				}
+			}
+			return std::pair{ upper, upper };
+		}
+
+		inline constexpr auto batch_width = 16;
+
+		template <std::random_access_iterator base_type>
+		constexpr auto prefetch([[maybe_unused]] base_type base, [[maybe_unused]] typename std::iterator_traits<base_type>::difference_type x) noexcept
+		{
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_prefetch)
+			if constexpr (std::contiguous_iterator<base_type>)
+				if (x and not std::is_constant_evaluated())
+					__builtin_prefetch(std::to_address(base + (x - 1)));
+#endif
+#endif
+		}
+
+		/* Descends for the values in [first, last) batch_width at a time. Each round moves every unfinished descent of the group down one level and prefetches
+		 * the node it moves to, so the cache misses of the group overlap instead of each waiting on the last. A descent remembers the last node it went left
+		 * from, and emit is called with it and the value, in order, once the group is done.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator value_iter, typename go_left_type, typename emit_type>
+		constexpr auto do_batch(const red_black_tree_node<tree_type, base_type> root, value_iter first, value_iter last, go_left_type go_left, emit_type emit) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			detail::prefetch(root.base, root.root);
+			while (first not_eq last) {
+				auto n = std::ptrdiff_t(std::min<std::iter_difference_t<value_iter>>(batch_width, std::distance(first, last)));
+				std::array<difference_type, batch_width> x{};
+				std::array<difference_type, batch_width> z{};
+				std::fill_n(x.begin(), n, root.root);
+				for (auto active = bool(root); active; ) {
+					active = false;
+					for (auto i = std::ptrdiff_t{}; i < n; ++i) {
+						if (not x[i])
+							continue;
+						auto node = red_black_tree_node<tree_type, base_type>{ root.base, x[i] };
+						if (go_left(node.key(), first[i])) {
+							z[i] = x[i];
+							x[i] = node.left().root;
+						} else
+							x[i] = node.right().root;
+						detail::prefetch(root.base, x[i]);
+						active = active or x[i];
+					}
+				}
+				for (auto i = std::ptrdiff_t{}; i < n; ++i)
+					emit(red_black_tree_node<tree_type, base_type>{ root.base, z[i] }, first[i]);
+				first += n;
+			}
+		}
+
+		/* Links the sorted positions [first, last) into a minimum height subtree. Every null link of such a tree sits at one of two depths, so coloring only the nodes
+		 * at red_depth red balances it. index is called once for every position in increasing order, so it can also hand out the nodes of a list.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename index_type>
+		[[nodiscard]] constexpr auto do_build(base_type base, typename std::iterator_traits<base_type>::difference_type first, typename std::iterator_traits<base_type>::difference_type last, typename std::iterator_traits<base_type>::difference_type depth, typename std::iterator_traits<base_type>::difference_type red_depth, index_type& index) noexcept
+		{
+			using node_type = red_black_tree_node<tree_type, base_type>;
+			if (first == last)
+				return node_type{};
+			auto mid = first + (last - first) / 2;
+			auto l = detail::do_build<tree_type>(base, first, mid, depth + 1, red_depth, index);
+			auto x = node_type{ base, index(mid) };
+			detail::update_prefix(x);
+			auto r = detail::do_build<tree_type>(base, mid + 1, last, depth + 1, red_depth, index);
+			x.color(depth == red_depth ? color::red : color::black);
+			x.left(l);
+			x.right(r);
+			if (l)
+				l.parent(x);
+			if (r)
+				r.parent(x);
+			detail::update(x);
+			return x;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename index_type>
+		[[nodiscard]] constexpr auto do_build(base_type base, typename std::iterator_traits<base_type>::difference_type n, index_type index) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			using node_type = red_black_tree_node<tree_type, base_type>;
+			auto red_depth = n > 1 ? difference_type(std::bit_width(std::make_unsigned_t<difference_type>(n)) - 1) : difference_type{ -1 };
+			auto root = detail::do_build<tree_type>(base, difference_type{}, n, difference_type{}, red_depth, index);
+			if (root)
+				root.parent(node_type{});
+			return root;
+		}
+
+		template <std::random_access_iterator base_type>
+		using level_counts = std::array<typename std::iterator_traits<base_type>::difference_type, 2 * std::numeric_limits<typename std::iterator_traits<base_type>::difference_type>::digits>;
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto count_levels(const red_black_tree_node<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type depth, level_counts<base_type>& counts) noexcept
+		{
+			if (not x)
+				return;
+			++counts[depth];
+			detail::count_levels(x.left(), depth + 1, counts);
+			detail::count_levels(x.right(), depth + 1, counts);
+		}
+
+		// Stores the breadth first position of each node of x in its parent link. An in order walk meets the nodes of each level from left to right.
+		template <typename tree_type, std::random_access_iterator base_type, typename remap_type>
+		constexpr auto number_levels(const red_black_tree_node<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type depth, level_counts<base_type>& next, remap_type& remap) noexcept
+		{
+			if (not x)
+				return;
+			detail::number_levels(x.left(), depth + 1, next, remap);
+			remap(x.root, next[depth]);
+			x.parent(red_black_tree_node<tree_type, base_type>{ x.base, next[depth]++ });
+			detail::number_levels(x.right(), depth + 1, next, remap);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		constexpr auto renumber_children(const red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			if (not x)
+				return;
+			const auto l = x.left();
+			const auto r = x.right();
+			detail::renumber_children(l);
+			detail::renumber_children(r);
+			x.left(l ? l.parent() : l);
+			x.right(r ? r.parent() : r);
+		}
+
+		// The n nodes of the tree at root must be exactly the positions [first, first + n).
+		template <typename tree_type, std::random_access_iterator base_type, typename remap_type>
+		[[nodiscard]] constexpr auto do_relayout(const red_black_tree_node<tree_type, base_type> root, typename std::iterator_traits<base_type>::difference_type first, typename std::iterator_traits<base_type>::difference_type n, remap_type& remap) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			using node_type = red_black_tree_node<tree_type, base_type>;
+			if (not root)
+				return root;
+
+			auto levels = level_counts<base_type>{};
+			detail::count_levels(root, difference_type{}, levels);
+			for (auto next = first; auto& level : levels)
+				next += std::exchange(level, next);
+			detail::number_levels(root, difference_type{}, levels, remap);
+			detail::renumber_children(root);
+
+			for (auto i = first; i < first + n; ++i)
+				for (auto dst = node_type{ root.base, i }.parent().root; dst not_eq i; dst = node_type{ root.base, i }.parent().root)
+					std::iter_swap(root.base + (i - 1), root.base + (dst - 1));
+
+			const auto new_root = node_type{ root.base, first };
+			new_root.parent(node_type{});
+			for (auto i = first; i < first + n; ++i) {
+				const auto x = node_type{ root.base, i };
+				if (x.left())
+					x.left().parent(x);
+				if (x.right())
+					x.right().parent(x);
+			}
+			return new_root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_select(red_black_tree_node<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type k) noexcept
+		{
+			while (x)
+				if (k < x.left().count())
+					x = x.left();
+				else if (k == x.left().count())
+					return x;
+				else {
+					k -= x.left().count() + 1;
+					x = x.right();
+				}
+			return x;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_rank(red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			auto k = x.left().count();
+			for (auto y = x.parent(); y; x = y, y = y.parent())
+				if (x == y.right())
+					k += y.left().count() + 1;
+			return k;
+		}
+
+		// Counts the keys ordered before value, a lower_bound descent that sums the sizes of the subtrees it passes on the left.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_count_less(red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto k = typename std::iterator_traits<base_type>::difference_type{};
+			while (x)
+				if (detail::before(less, x.key(), value)) {
+					k += x.left().count() + 1;
+					x = x.right();
+				} else
+					x = x.left();
+			return k;
+		}
+
+		/* Combines the elements with keys in [lo, hi) below the first node whose key is in the range, then adds the ones of its left subtree that aren't
+		 * ordered before lo and the ones of its right subtree that are ordered before hi, each of which takes one path down.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_aggregate_range(red_black_tree_node<tree_type, base_type> x, const V& lo, const V& hi, less_type& less) noexcept
+		{
+			using value_type = aggregate_value<tree_type>;
+			while (x and (detail::before(less, x.key(), lo) or not detail::before(less, x.key(), hi)))
+				x = detail::before(less, x.key(), lo) ? x.right() : x.left();
+			if (not x)
+				return value_type(tree_type::identity());
+			auto left = value_type(tree_type::identity());
+			for (auto y = x.left(); y; )
+				if (detail::before(less, y.key(), lo))
+					y = y.right();
+				else {
+					left = value_type(tree_type::combine(tree_type::combine(y.lift(), y.right().aggregate()), left));
+					y = y.left();
+				}
+			auto right = value_type(tree_type::identity());
+			for (auto y = x.right(); y; )
+				if (detail::before(less, y.key(), hi)) {
+					right = value_type(tree_type::combine(right, tree_type::combine(y.left().aggregate(), y.lift())));
+					y = y.right();
+				} else
+					y = y.left();
+			return value_type(tree_type::combine(tree_type::combine(left, x.lift()), right));
+		}
+
+		/* Calls f with every node of the subtree at x in order, keeping the left spine still to be visited on a stack instead of climbing parent links back
+		 * up. A valid tree is at most twice as deep as the number of bits of an index, which bounds the stack.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename function_type>
+		constexpr auto do_flatten(red_black_tree_node<tree_type, base_type> x, function_type& f) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			std::array<difference_type, 2 * std::numeric_limits<std::make_unsigned_t<difference_type>>::digits> stack{};
+			auto top = std::size_t{};
+			for (;;) {
+				for (; x; x = x.left())
+					stack[top++] = x.root;
+				if (not top)
+					return;
+				x = red_black_tree_node<tree_type, base_type>{ x.base, stack[--top] };
+				f(x);
+				x = x.right();
+			}
+		}
+
+		// The digest of the keys ordered before value, or of those not ordered after it when through is true.
+		template <bool through, typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_digest_before(red_black_tree_node<tree_type, base_type> x, const V& value, less_type& less) noexcept
+		{
+			auto d = hash_type<tree_type>{};
+			while (x)
+				if (through ? not detail::before(less, value, x.key()) : detail::before(less, x.key(), value)) {
+					d = hash_type<tree_type>(d + x.digest() - x.right().digest());
+					x = x.right();
+				} else
+					x = x.left();
+			return d;
+		}
+
+		/* Reports the elements of the subtree at a, whose keys lie strictly between those of lo and hi, that have no equivalent in the tree rooted at b, and
+		 * the elements of b in the same key range that have none in a. Only ranges whose digests differ are looked into.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename emit_type, typename other_emit_type>
+		constexpr auto do_diff(const red_black_tree_node<tree_type, base_type> a, const red_black_tree_node<tree_type, base_type> lo, const red_black_tree_node<tree_type, base_type> hi, const red_black_tree_node<tree_type, base_type> b, less_type& less, emit_type& emit, other_emit_type& other_emit) noexcept -> void
+		{
+			auto upper = hi ? detail::do_digest_before<false>(b, hi.key(), less) : b.digest();
+			auto lower = lo ? detail::do_digest_before<true>(b, lo.key(), less) : hash_type<tree_type>{};
+			if (a.digest() == hash_type<tree_type>(upper - lower))
+				return;
+			if (not a) {
+				for (auto x = lo ? detail::do_upper_bound(b, lo.key(), less) : b ? detail::min(b) : b; x and (not hi or detail::before(less, x.key(), hi.key())); x = detail::successor(x))
+					other_emit(x);
+				return;
+			}
+			if (not detail::do_find(b, a.key(), less))
+				emit(a);
+			detail::do_diff(a.left(), lo, a, b, less, emit, other_emit);
+			detail::do_diff(a.right(), a, hi, b, less, emit, other_emit);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto black_height(red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			auto h = typename std::iterator_traits<base_type>::difference_type{};
+			for (; x; x = x.left())
+				if (color::black == x.color())
+					++h;
+			return h;
+		}
+
+		// Makes x the black root of a tree of its own. Blackening a red root keeps every property and only raises the black height.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto detach(const red_black_tree_node<tree_type, base_type> x) noexcept
+		{
+			if (x) {
+				x.parent(red_black_tree_node<tree_type, base_type>{});
+				x.color(color::black);
+			}
+			return x;
+		}
+
+		/* Joins the trees rooted at l and r with pivot between them, where no key of l is greater than pivot and no key of r is less. pivot replaces the first black
+		 * node on the inner spine of the taller tree with the black height of the shorter one as a red node, so only insert_fixup is left to do.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_join(red_black_tree_node<tree_type, base_type> l, const red_black_tree_node<tree_type, base_type> pivot, red_black_tree_node<tree_type, base_type> r) noexcept
+		{
+			auto hl = detail::black_height(l);
+			auto hr = detail::black_height(r);
+			auto c = hl > hr ? l : r;
+			auto h = hl > hr ? hl : hr;
+			while (hl not_eq hr and (color::black not_eq c.color() or h not_eq (hl > hr ? hr : hl))) {
+				if (color::black == c.color())
+					--h;
+				c = hl > hr ? c.right() : c.left();
+			}
+			auto p = hl == hr ? red_black_tree_node<tree_type, base_type>{} : c ? c.parent() : hl > hr ? detail::max(l) : detail::min(r);
+			pivot.left(hl > hr ? c : l);
+			pivot.right(hl > hr ? r : c);
+			pivot.parent(p);
+			if (pivot.left())
+				pivot.left().parent(pivot);
+			if (pivot.right())
+				pivot.right().parent(pivot);
+			if (hl == hr) {
+				pivot.color(color::black);
+				detail::update(pivot);
+				return pivot;
+			}
+			if (hl > hr)
+				p.right(pivot);
+			else
+				p.left(pivot);
+			pivot.color(color::red);
+			detail::update_path(pivot);
+			return detail::insert_fixup(hl > hr ? l : r, pivot);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_join(const red_black_tree_node<tree_type, base_type> l, const red_black_tree_node<tree_type, base_type> r) noexcept
+		{
+			if (not l)
+				return r;
+			if (not r)
+				return l;
+			auto pivot = detail::max(l);
+			return detail::do_join(detail::do_erase(l, pivot), pivot, r);
+		}
+
+		// Splits the tree rooted at x into the keys ordered before value and the rest.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_split(const red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept -> std::pair<red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>>
+		{
+			if (not x)
+				return { x, x };
+			auto l = detail::detach(x.left());
+			auto r = detail::detach(x.right());
+			if (detail::before(less, x.key(), value)) {
+				auto [rl, rr] = detail::do_split(r, value, less);
+				return { detail::do_join(l, x, rl), rr };
+			}
+			auto [ll, lr] = detail::do_split(l, value, less);
+			return { ll, detail::do_join(lr, x, r) };
+		}
+
+		// Splits the tree rooted at x into the keys ordered before value, a detached node equivalent to value if there is one, and the keys ordered after it.
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_split3(const red_black_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept -> std::tuple<red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>>
+		{
+			if (not x)
+				return { x, x, x };
+			auto l = detail::detach(x.left());
+			auto r = detail::detach(x.right());
+			if (detail::before(less, x.key(), value)) {
+				auto [rl, m, rr] = detail::do_split3(r, value, less);
+				return { detail::do_join(l, x, rl), m, rr };
+			}
+			if (detail::before(less, value, x.key())) {
+				auto [ll, m, lr] = detail::do_split3(l, value, less);
+				return { ll, m, detail::do_join(lr, x, r) };
+			}
+			return { l, x, r };
+		}
+
+		/* Splits the tree rooted at root into the elements before z and the elements from z on, which need not be distinguishable by key. Walking up from z joins
+		 * each ancestor and its other subtree onto the matching side. The black heights of the joined trees only grow on the way up, so this is O(log n).
+		*/
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_split_before(const red_black_tree_node<tree_type, base_type> root, const red_black_tree_node<tree_type, base_type> z) noexcept -> std::pair<red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>>
+		{
+			using node_type = red_black_tree_node<tree_type, base_type>;
+			if (not z)
+				return { root, z };
+			auto x = z;
+			auto p = z.parent();
+			auto l = detail::detach(z.left());
+			auto r = detail::do_join(node_type{}, z, detail::detach(z.right()));
+			while (p) {
+				auto next = p.parent();
+				if (x == p.right())
+					l = detail::do_join(detail::detach(p.left()), p, l);
+				else
+					r = detail::do_join(r, p, detail::detach(p.right()));
+				x = p;
+				p = next;
+			}
+			return { l, r };
+		}
+
+		/* Rebuilds the tree rooted at root as the balanced trees of the elements for which pred returns false and true, keeping their order. The elements are
+		 * threaded into two lists through their left links while walking in order, which never looks at the left link of an element it has passed.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename pred_type>
+		[[nodiscard]] constexpr auto do_partition(const red_black_tree_node<tree_type, base_type> root, pred_type& pred) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			using node_type = red_black_tree_node<tree_type, base_type>;
+			auto heads = std::array<node_type, 2>{};
+			auto tails = std::array<node_type, 2>{};
+			auto counts = std::array<difference_type, 2>{};
+			for (auto x = root ? detail::min(root) : root; x; ) {
+				auto next = detail::successor(x);
+				auto side = std::size_t(bool(pred(x.base[x.root - 1])));
+				if (counts[side]++)
+					tails[side].left(x);
+				else
+					heads[side] = x;
+				tails[side] = x;
+				x = next;
+			}
+			auto build = [&](std::size_t side) {
+				auto head = heads[side];
+				auto index = [&](difference_type) { auto x = head; head = head.left(); return x.root; };
+				return detail::do_build<tree_type>(root.base, counts[side], index);
+			};
+			return std::pair{ build(0), build(1) };
+		}
+
+		struct sequential final
+		{
+			constexpr auto operator()(auto&& f, auto&& g) const noexcept
+			{
+				f();
+				g();
+			}
+		};
+
+		// Runs the two independent halves of a set operation through fork once the subtree is tall enough to be worth it. The halves touch disjoint nodes.
+		template <typename tree_type, std::random_access_iterator base_type, typename fork_type>
+		constexpr auto fork_if(const red_black_tree_node<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type grain, fork_type& fork, auto&& f, auto&& g) noexcept
+		{
+			if constexpr (std::is_same_v<fork_type, sequential>)
+				fork(f, g);
+			else if (detail::black_height(x) < grain)
+				sequential{}(f, g);
+			else
+				fork(f, g);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+		[[nodiscard]] constexpr auto do_union(const red_black_tree_node<tree_type, base_type> a, const red_black_tree_node<tree_type, base_type> b, less_type less, typename std::iterator_traits<base_type>::difference_type grain, fork_type& fork) noexcept -> std::pair<red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>>
+		{
+			if (not a or not b)
+				return { a ? a : b, {} };
+			auto l = detail::detach(a.left());
+			auto r = detail::detach(a.right());
+			auto [bl, m, br] = detail::do_split3(b, a.key(), less);
+			auto left = decltype(detail::do_union(l, bl, less, grain, fork)){};
+			auto right = left;
+			detail::fork_if(a, grain, fork, [&] { left = detail::do_union(l, bl, less, grain, fork); }, [&] { right = detail::do_union(r, br, less, grain, fork); });
+			return { detail::do_join(left.first, a, right.first), m ? detail::do_join(left.second, m, right.second) : detail::do_join(left.second, right.second) };
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+		[[nodiscard]] constexpr auto do_intersection(const red_black_tree_node<tree_type, base_type> a, const red_black_tree_node<tree_type, base_type> b, less_type less, typename std::iterator_traits<base_type>::difference_type grain, fork_type& fork) noexcept -> std::pair<red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>>
+		{
+			if (not a or not b)
+				return { {}, a ? a : b };
+			auto l = detail::detach(a.left());
+			auto r = detail::detach(a.right());
+			auto [bl, m, br] = detail::do_split3(b, a.key(), less);
+			auto left = decltype(detail::do_intersection(l, bl, less, grain, fork)){};
+			auto right = left;
+			detail::fork_if(a, grain, fork, [&] { left = detail::do_intersection(l, bl, less, grain, fork); }, [&] { right = detail::do_intersection(r, br, less, grain, fork); });
+			if (m)
+				return { detail::do_join(left.first, a, right.first), detail::do_join(left.second, m, right.second) };
+			return { detail::do_join(left.first, right.first), detail::do_join(left.second, a, right.second) };
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+		[[nodiscard]] constexpr auto do_difference(const red_black_tree_node<tree_type, base_type> a, const red_black_tree_node<tree_type, base_type> b, less_type less, typename std::iterator_traits<base_type>::difference_type grain, fork_type& fork) noexcept -> std::pair<red_black_tree_node<tree_type, base_type>, red_black_tree_node<tree_type, base_type>>
+		{
+			if (not a or not b)
+				return { a, b };
+			auto l = detail::detach(b.left());
+			auto r = detail::detach(b.right());
+			auto [al, m, ar] = detail::do_split3(a, b.key(), less);
+			auto left = decltype(detail::do_difference(al, l, less, grain, fork)){};
+			auto right = left;
+			detail::fork_if(b, grain, fork, [&] { left = detail::do_difference(al, l, less, grain, fork); }, [&] { right = detail::do_difference(ar, r, less, grain, fork); });
+			if (m)
+				left.second = detail::do_join(left.second, m, red_black_tree_node<tree_type, base_type>{});
+			return { detail::do_join(left.first, right.first), detail::do_join(left.second, b, right.second) };
 		}
 
 		template <typename tree_type, std::random_access_iterator base_type>
@@ -459,20 +1321,145 @@ namespace red_black_tree {
 					return false;
 				if (curr.color() == color::red and curr.parent().color() == color::red)
 					return false;
+				if constexpr (prefixed<tree_type>)
+					if (curr.prefix() not_eq typename tree_type::prefix_type(tree_type::prefix(curr.key())))
+						return false;
 
 				if (auto next = detail::checked_successor(curr, extent, curr_height))
 					std::tie(curr, curr_height) = next.value();
 				else
 					return false;
 
-				if (curr and less(curr.key(), prev.key()))
+				if (curr and detail::before(less, curr.key(), prev.key()))
 					return false;
+				if constexpr (counted<tree_type>)
+					if (prev.count() not_eq prev.left().count() + prev.right().count() + 1)
+						return false;
+				if constexpr (digested<tree_type>)
+					if (prev.digest() not_eq detail::subtree_digest(prev))
+						return false;
+				if constexpr (aggregated<tree_type>)
+					if (prev.aggregate() not_eq detail::subtree_aggregate(prev))
+						return false;
+			}
+
+			return true;
+		}
+		/* Checks the subtree at x, whose parent must be parent and whose keys must be ordered between those of lo and hi where they aren't null, and returns its
+		 * black height or -1. Every node is only checked against its neighbours and the bounds it inherits, so the subtrees of the top levels can be checked
+		 * through fork at the same time. The depth bound keeps corrupted links from recursing any deeper than a valid tree of extent nodes could be.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+		[[nodiscard]] constexpr auto do_validate(const red_black_tree_node<tree_type, base_type> x, const red_black_tree_node<tree_type, base_type> parent, const red_black_tree_node<tree_type, base_type> lo, const red_black_tree_node<tree_type, base_type> hi, typename std::iterator_traits<base_type>::difference_type depth, typename std::iterator_traits<base_type>::difference_type extent, less_type& less, typename std::iterator_traits<base_type>::difference_type levels, fork_type& fork) noexcept -> typename std::iterator_traits<base_type>::difference_type
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			if (not x)
+				return 1;
+			if (depth > 2 * difference_type(std::bit_width(std::make_unsigned_t<difference_type>(extent))) or not detail::check_index(x, extent) or not detail::check_link(x, parent))
+				return -1;
+			if (color::red == x.color() and (not parent or color::red == parent.color()))
+				return -1;
+			if ((lo and detail::before(less, x.key(), lo.key())) or (hi and detail::before(less, hi.key(), x.key())))
+				return -1;
+			if constexpr (prefixed<tree_type>)
+				if (x.prefix() not_eq typename tree_type::prefix_type(tree_type::prefix(x.key())))
+					return -1;
+			auto l = difference_type{};
+			auto r = difference_type{};
+			auto f = [&] { l = detail::do_validate(x.left(), x, lo, x, depth + 1, extent, less, levels, fork); };
+			auto g = [&] { r = detail::do_validate(x.right(), x, x, hi, depth + 1, extent, less, levels, fork); };
+			if (depth < levels)
+				fork(f, g);
+			else
+				sequential{}(f, g);
+			if (l < 0 or l not_eq r)
+				return -1;
+			if constexpr (counted<tree_type>)
+				if (x.count() not_eq x.left().count() + x.right().count() + 1)
+					return -1;
+			if constexpr (digested<tree_type>)
+				if (x.digest() not_eq detail::subtree_digest(x))
+					return -1;
+			if constexpr (aggregated<tree_type>)
+				if (x.aggregate() not_eq detail::subtree_aggregate(x))
+					return -1;
+			return l + (color::black == x.color());
+		}
+
+		/* Checks x against its parent, its children, the keys of its ancestors and the extreme keys of its subtrees, and that the paths through x have
+		 * black_height black nodes. The subtrees of x are taken to be valid, so their black height is read off their leftmost path. x passes if its parent
+		 * links don't lead back to root, since it isn't part of the tree then. Every walk is bounded by the height of a valid tree of extent nodes.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_validate_node(const red_black_tree_node<tree_type, base_type> x, const red_black_tree_node<tree_type, base_type> root, typename std::iterator_traits<base_type>::difference_type extent, typename std::iterator_traits<base_type>::difference_type black_height, less_type& less) noexcept
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			using node_type = red_black_tree_node<tree_type, base_type>;
+			const auto height = 2 * difference_type(std::bit_width(std::make_unsigned_t<difference_type>(extent)));
+			if (not detail::check_index(x, extent))
+				return false;
+
+			auto depth = difference_type(color::black == x.color());
+			auto ordered = true;
+			auto steps = difference_type{};
+			for (auto curr = x; curr not_eq root; curr = curr.parent(), ++steps) {
+				auto parent = curr.parent();
+				if (steps == height or not detail::check_index(parent, extent) or (parent.left() not_eq curr and parent.right() not_eq curr))
+					return true;
+				ordered = ordered and not (parent.left() == curr ? detail::before(less, parent.key(), x.key()) : detail::before(less, x.key(), parent.key()));
+				depth += color::black == parent.color();
 			}
+			if (not ordered or (x.left() and x.left() == x.right()))
+				return false;
+			if (x == root ? bool(x.parent()) or color::red == x.color() : color::red == x.color() and color::red == x.parent().color())
+				return false;
+			if constexpr (prefixed<tree_type>)
+				if (x.prefix() not_eq typename tree_type::prefix_type(tree_type::prefix(x.key())))
+					return false;
+
+			auto subtree = [&](const node_type child, const bool left) {
+				auto black = difference_type{};
+				if (not child)
+					return black == black_height - depth;
+				if (not detail::check_index(child, extent) or child.parent() not_eq x)
+					return false;
+				auto extreme = child;
+				for (auto i = steps; left ? bool(extreme.right()) : bool(extreme.left()); extreme = left ? extreme.right() : extreme.left())
+					if (++i > height or not detail::check_index(left ? extreme.right() : extreme.left(), extent))
+						return false;
+				if (left ? detail::before(less, x.key(), extreme.key()) : detail::before(less, extreme.key(), x.key()))
+					return false;
+				auto i = steps;
+				for (auto curr = child; curr; curr = curr.left()) {
+					if (++i > height or not detail::check_index(curr, extent))
+						return false;
+					black += color::black == curr.color();
+				}
+				return black == black_height - depth;
+			};
+			if (not subtree(x.left(), true) or not subtree(x.right(), false))
+				return false;
 
+			for (auto curr : std::array{ x, x.parent() }) {
+				if (not curr)
+					continue;
+				if ((curr.left() and not detail::check_index(curr.left(), extent)) or (curr.right() and not detail::check_index(curr.right(), extent)))
+					return false;
+				if constexpr (counted<tree_type>)
+					if (curr.count() not_eq curr.left().count() + curr.right().count() + 1)
+						return false;
+				if constexpr (digested<tree_type>)
+					if (curr.digest() not_eq detail::subtree_digest(curr))
+						return false;
+				if constexpr (aggregated<tree_type>)
+					if (curr.aggregate() not_eq detail::subtree_aggregate(curr))
+						return false;
+			}
 			return true;
 		}
 	}
 
+
 	/* Implements a forward iterator for an intrusive balanced binary search tree. tree_type provides types named
 	 * left_type, right_type, parent_type, key_type, and color_type which are unique types explicitly convertable to
 	 * difference_type for the first 3, and bool for color. the value_type of base_type must implement type based get
@@ -603,6 +1590,64 @@ namespace red_black_tree {
 		return difference_type(detail::do_insert(node_type{ base, root }, node_type{ base, difference_type(std::distance(base, it) + 1) }, less));
 	}
 
+	/* Inserts the object pointed to by it like insert, but first tries the position just before hint and then the one just after it, which only costs two
+	 * comparisons when the hint is right. returns an iterator to the inserted element and the new root, so hints can be chained when loading sorted data.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto insert(base_type base, typename std::iterator_traits<base_type>::difference_type root, forward_iter<tree_type, base_type> hint, base_type it, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto z = node_type{ base, difference_type(std::distance(base, it) + 1) };
+		return std::pair{ forward_iter<tree_type, base_type>{ base, z.root }, difference_type(detail::do_insert_hint(node_type{ base, root }, node_type{ base, hint.root }, z, less)) };
+	}
+
+	/* Links the objects in [first, last) of the random access range at base, which must already be in key order, into a new balanced tree and returns its root.
+	 * Any previous links of these objects are overwritten. This is linear and does no comparisons.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto build_sorted(base_type base, base_type first, base_type last) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		auto offset = std::distance(base, first) + 1;
+		return difference_type(detail::do_build<tree_type>(base, std::distance(first, last), [=](difference_type i) { return offset + i; }));
+	}
+
+	/* Links the objects in [first, last) of the random access range at base into a new balanced tree and returns its root. indices must have room for
+	 * std::distance(first, last) difference_type values and is used to sort a permutation of the objects instead of the objects themselves.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator index_type, typename less_type>
+	[[nodiscard]] constexpr auto build(base_type base, base_type first, base_type last, index_type indices, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto n = std::distance(first, last);
+		for (auto i = difference_type{}, offset = std::distance(base, first) + 1; i < n; ++i)
+			indices[i] = offset + i;
+		std::sort(indices, indices + n, [&](difference_type a, difference_type b) { return detail::before(less, node_type{ base, a }.key(), node_type{ base, b }.key()); });
+		return difference_type(detail::do_build<tree_type>(base, n, [=](difference_type i) { return difference_type(indices[i]); }));
+	}
+
+	/* Moves the objects in [first, last) of the random access range at base, which must be exactly the elements of the tree rooted at root, so the tree is stored
+	 * in breadth first order from first, and returns the new root, which is first. The shape of the tree doesn't change, but the top levels end up packed
+	 * together and every descent visits increasing positions. remap is called with the old and new link of every element before anything moves so other
+	 * structures over the same range can be patched. This is linear, does no comparisons and swaps objects with std::iter_swap.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename remap_type>
+	[[nodiscard]] constexpr auto relayout(base_type base, base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, remap_type remap) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		return difference_type(detail::do_relayout(node_type{ base, root }, difference_type(std::distance(base, first) + 1), difference_type(std::distance(first, last)), remap));
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto relayout(base_type base, base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		return relayout<tree_type>(base, first, last, root, [](difference_type, difference_type) {});
+	}
+
 	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
 	[[nodiscard]] constexpr auto upper_bound(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
 	{
@@ -627,6 +1672,34 @@ namespace red_black_tree {
 		return forward_iter<tree_type, base_type>{ base, difference_type(detail::do_find(node_type{ base, root }, value, less)) };
 	}
 
+	/* Batched versions of lower_bound, upper_bound and find. They look up every value in [first, last) and write an iterator for each, in order, to out,
+	 * returning out past the last one written. Lookups are run in groups that descend the tree together so the memory latency of one hides behind the
+	 * others, which pays off once the tree no longer fits in cache.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator value_iter, std::output_iterator<forward_iter<tree_type, base_type>> out_type, typename less_type>
+	constexpr auto lower_bound_batch(base_type base, typename std::iterator_traits<base_type>::difference_type root, value_iter first, value_iter last, out_type out, less_type less) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		detail::do_batch(node_type{ base, root }, first, last, [&](const auto& key, const auto& value) { return not detail::before(less, key, value); }, [&](node_type x, const auto&) { *out++ = forward_iter<tree_type, base_type>{ base, x.root }; });
+		return out;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator value_iter, std::output_iterator<forward_iter<tree_type, base_type>> out_type, typename less_type>
+	constexpr auto upper_bound_batch(base_type base, typename std::iterator_traits<base_type>::difference_type root, value_iter first, value_iter last, out_type out, less_type less) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		detail::do_batch(node_type{ base, root }, first, last, [&](const auto& key, const auto& value) { return detail::before(less, value, key); }, [&](node_type x, const auto&) { *out++ = forward_iter<tree_type, base_type>{ base, x.root }; });
+		return out;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator value_iter, std::output_iterator<forward_iter<tree_type, base_type>> out_type, typename less_type>
+	constexpr auto find_batch(base_type base, typename std::iterator_traits<base_type>::difference_type root, value_iter first, value_iter last, out_type out, less_type less) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		detail::do_batch(node_type{ base, root }, first, last, [&](const auto& key, const auto& value) { return not detail::before(less, key, value); }, [&](node_type x, const auto& value) { *out++ = forward_iter<tree_type, base_type>{ base, x and not detail::before(less, value, x.key()) ? x.root : 0 }; });
+		return out;
+	}
+
 	// Erases an element it from the structure rooted at root in the random access range at base. returns the new root.
 	template <typename tree_type, std::random_access_iterator base_type>
 	[[nodiscard]] constexpr auto erase(typename std::iterator_traits<base_type>::difference_type root, forward_iter<tree_type, base_type> it) noexcept
@@ -636,6 +1709,32 @@ namespace red_black_tree {
 		return difference_type(detail::do_erase<tree_type>(node_type{ it.base, root }, node_type{ it.base, it.root }));
 	}
 
+	/* Erases the elements [first, last) from the tree rooted at root by splitting the tree before first and last and joining the outer parts, so the cost
+	 * doesn't depend on how many elements are erased. returns the new root and the root of a tree of the erased elements, which is how they are reported.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto erase(typename std::iterator_traits<base_type>::difference_type root, forward_iter<tree_type, base_type> first, forward_iter<tree_type, base_type> last) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [l, rest] = detail::do_split_before(node_type{ first.base, root }, node_type{ first.base, first.root });
+		auto [erased, r] = detail::do_split_before(rest, node_type{ first.base, last.root });
+		return std::pair{ difference_type(detail::do_join(l, r)), difference_type(erased) };
+	}
+
+	/* Erases every element of the tree rooted at root for which pred, called with a reference to it, returns true. pred has to see every element anyway, so
+	 * this walks the tree once and rebuilds both parts as balanced trees in O(n) without comparing keys. returns the new root and the root of a tree of the
+	 * erased elements.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename pred_type>
+	[[nodiscard]] constexpr auto erase_if(base_type base, typename std::iterator_traits<base_type>::difference_type root, pred_type pred) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [kept, erased] = detail::do_partition(node_type{ base, root }, pred);
+		return std::pair{ difference_type(kept), difference_type(erased) };
+	}
+
 	// Given a node in the tree src, and a node out of the tree dst, relink the tree so dst is in the tree where src was. Src's key must be the correct key for dst's position in the tree.
 	template <typename tree_type, std::random_access_iterator base_type>
 	[[nodiscard]] constexpr auto node_relink(typename std::iterator_traits<base_type>::difference_type root, base_type dst, forward_iter<tree_type, base_type> src) noexcept
@@ -654,6 +1753,81 @@ namespace red_black_tree {
 		return difference_type(detail::do_node_swap(node_type{ a.base, root }, node_type{ a.base, a.root }, node_type{ b.base, b.root }));
 	}
 
+	// Joins the trees rooted at left and right with the object pivot, which is in neither, between them and returns the new root. No key in left may be ordered after pivot's and none in right before it.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto join(base_type base, typename std::iterator_traits<base_type>::difference_type left, base_type pivot, typename std::iterator_traits<base_type>::difference_type right) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto z = node_type{ base, difference_type(std::distance(base, pivot) + 1) };
+		detail::update_prefix(z);
+		return difference_type(detail::do_join(node_type{ base, left }, z, node_type{ base, right }));
+	}
+
+	// Splits the tree rooted at root into a tree of the elements ordered before value and a tree of the rest. returns both roots.
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto split(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [l, r] = detail::do_split(node_type{ base, root }, value, less);
+		return std::pair{ difference_type(l), difference_type(r) };
+	}
+
+	/* Set operations on two trees in the same range, treating each as a set. Each returns the root of the result and the root of a tree holding every element of
+	 * either input that is not in the result, so no element is lost track of. They run in O(m log(n / m + 1)) for trees of sizes m <= n. The overloads taking fork
+	 * call fork(f, g) to run the two independent halves of the recursion, for example on a thread pool, whenever the subtree being split has a black height of at
+	 * least grain. fork must return after both have run.
+	*/
+
+	// The result holds every element of root and the elements of other_root whose keys are not in root.
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+	[[nodiscard]] constexpr auto set_union(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type other_root, less_type less, typename std::iterator_traits<base_type>::difference_type grain, fork_type fork) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [r, rest] = detail::do_union(node_type{ base, root }, node_type{ base, other_root }, less, grain, fork);
+		return std::pair{ difference_type(r), difference_type(rest) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto set_union(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type other_root, less_type less) noexcept
+	{
+		return set_union<tree_type>(base, root, other_root, less, {}, detail::sequential{});
+	}
+
+	// The result holds the elements of root whose keys are also in other_root.
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+	[[nodiscard]] constexpr auto set_intersection(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type other_root, less_type less, typename std::iterator_traits<base_type>::difference_type grain, fork_type fork) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [r, rest] = detail::do_intersection(node_type{ base, root }, node_type{ base, other_root }, less, grain, fork);
+		return std::pair{ difference_type(r), difference_type(rest) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto set_intersection(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type other_root, less_type less) noexcept
+	{
+		return set_intersection<tree_type>(base, root, other_root, less, {}, detail::sequential{});
+	}
+
+	// The result holds the elements of root whose keys are not in other_root.
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+	[[nodiscard]] constexpr auto set_difference(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type other_root, less_type less, typename std::iterator_traits<base_type>::difference_type grain, fork_type fork) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [r, rest] = detail::do_difference(node_type{ base, root }, node_type{ base, other_root }, less, grain, fork);
+		return std::pair{ difference_type(r), difference_type(rest) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto set_difference(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type other_root, less_type less) noexcept
+	{
+		return set_difference<tree_type>(base, root, other_root, less, {}, detail::sequential{});
+	}
+
 	template <std::random_access_iterator base_type>
 	[[nodiscard]] constexpr auto empty(typename std::iterator_traits<base_type>::difference_type root) noexcept
 	{
@@ -667,16 +1841,134 @@ namespace red_black_tree {
 		return difference_type(std::numeric_limits<difference_type>::max() - 1);
 	}
 
+	// Like max_size<base_type>, but also accounts for the bit of a link taken by a packed_color.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto max_size() noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using link_type = typename detail::color_packing<typename tree_type::color_type>::link_type;
+		if constexpr (std::is_void_v<link_type>)
+			return max_size<base_type>();
+		else
+			return std::min(max_size<base_type>(), difference_type((std::make_unsigned_t<difference_type>{1} << (sizeof(link_type) * CHAR_BIT - 1)) - 1));
+	}
+
+	// Writes the links of the tree rooted at root to out in key order and returns out, without the parent walks of iterating.
+	template <typename tree_type, std::random_access_iterator base_type, typename out_type>
+	constexpr auto flatten(base_type base, typename std::iterator_traits<base_type>::difference_type root, out_type out) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto f = [&](node_type x) { *out++ = x.root; };
+		detail::do_flatten(node_type{ base, root }, f);
+		return out;
+	}
+
+	// Also writes project(key) of every element to keys in the same order, and returns both output iterators.
+	template <typename tree_type, std::random_access_iterator base_type, typename out_type, typename key_out, typename project_type>
+	constexpr auto flatten(base_type base, typename std::iterator_traits<base_type>::difference_type root, out_type out, key_out keys, project_type project) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto f = [&](node_type x) {
+			*out++ = x.root;
+			*keys++ = project(x.key());
+		};
+		detail::do_flatten(node_type{ base, root }, f);
+		return std::pair{ out, keys };
+	}
+
+	// Constant time when tree_type provides count_type, otherwise linear.
 	template <typename tree_type, std::random_access_iterator base_type>
 	[[nodiscard]] constexpr auto size(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
 	{
-		return std::distance(begin<tree_type>(base, root), end<tree_type>(base));
+		if constexpr (detail::counted<tree_type>)
+			return detail::red_black_tree_node<tree_type, base_type>{ base, root }.count();
+		else
+			return std::distance(begin<tree_type>(base, root), end<tree_type>(base));
 	}
 
+	/* The following require tree_type to provide count_type, a field holding the size of the subtree rooted at each node which is explicitly convertible to and
+	 * from difference_type. It is maintained by every operation that changes the shape of the tree.
+	*/
+
+	// Returns an iterator to the kth smallest element counting from 0, or end if there are not that many elements.
+	template <typename tree_type, std::random_access_iterator base_type>
+	requires detail::counted<tree_type>
+	[[nodiscard]] constexpr auto select(base_type base, typename std::iterator_traits<base_type>::difference_type root, typename std::iterator_traits<base_type>::difference_type k) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		return forward_iter<tree_type, base_type>{ base, difference_type(detail::do_select(node_type{ base, root }, k)) };
+	}
+
+	// Returns the number of elements before it. end has the rank of the size of the tree.
+	template <typename tree_type, std::random_access_iterator base_type>
+	requires detail::counted<tree_type>
+	[[nodiscard]] constexpr auto rank(typename std::iterator_traits<base_type>::difference_type root, forward_iter<tree_type, base_type> it) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		return it.root ? detail::do_rank(node_type{ it.base, it.root }) : node_type{ it.base, root }.count();
+	}
+
+	// Returns the number of elements with keys in [lo, hi).
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	requires detail::counted<tree_type>
+	[[nodiscard]] constexpr auto count_range(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& lo, const V& hi, less_type less) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto k = detail::do_count_less(node_type{ base, root }, hi, less) - detail::do_count_less(node_type{ base, root }, lo, less);
+		return k > 0 ? k : decltype(k){};
+	}
+
+	// Returns the elements with keys in [lo, hi) combined in key order, or tree_type::identity() if there are none.
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	requires detail::aggregated<tree_type>
+	[[nodiscard]] constexpr auto aggregate_range(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& lo, const V& hi, less_type less) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		return detail::do_aggregate_range(node_type{ base, root }, lo, hi, less);
+	}
+
+	// Recomputes the aggregates from it up to the root after the element at it changed in a way that changes tree_type::lift of it.
+	template <typename tree_type, std::random_access_iterator base_type>
+	requires detail::aggregated<tree_type>
+	constexpr auto update_aggregate(forward_iter<tree_type, base_type> it) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		detail::update_path(node_type{ it.base, it.root });
+	}
+
+	// Returns the digest of the keys of the tree rooted at root, which is the same for any tree of the same keys.
+	template <typename tree_type, std::random_access_iterator base_type>
+	requires detail::digested<tree_type>
+	[[nodiscard]] constexpr auto digest(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		return node_type{ base, root }.digest();
+	}
+
+	/* Compares two trees, treating each as a set, and writes an iterator to every element of root whose key isn't in other_root to out and an iterator to
+	 * every element of other_root whose key isn't in root to other_out. Key ranges with equal digests on both sides are skipped, so trees that differ in k
+	 * keys are compared in about O(k log^2 n) whatever their shapes. returns both output iterators.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename out_type, typename other_out_type>
+	requires detail::digested<tree_type>
+	constexpr auto diff(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type other_base, typename std::iterator_traits<base_type>::difference_type other_root, less_type less, out_type out, other_out_type other_out) noexcept
+	{
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto emit = [&](node_type x) { *out++ = forward_iter<tree_type, base_type>{ base, x.root }; };
+		auto other_emit = [&](node_type x) { *other_out++ = forward_iter<tree_type, base_type>{ other_base, x.root }; };
+		detail::do_diff(node_type{ base, root }, node_type{}, node_type{}, node_type{ other_base, other_root }, less, emit, other_emit);
+		return std::pair{ out, other_out };
+	}
+
+	// With a digest_type, trees whose digests differ are unequal without comparing their keys, which assumes equiv only holds for keys with equal hashes.
 	template <typename tree_type, std::random_access_iterator base_type, typename equiv_type>
 	[[nodiscard]] constexpr auto equal(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type other_base, typename std::iterator_traits<base_type>::difference_type other_root, equiv_type equiv) noexcept
 	{
 		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		if constexpr (detail::digested<tree_type>)
+			if (node_type{ base, root }.digest() not_eq node_type{ other_base, other_root }.digest())
+				return false;
 		auto it = begin<tree_type>(base, root);
 		auto it2 = begin<tree_type>(other_base, other_root);
 		while (it not_eq end<tree_type>(base) and it2 not_eq end<tree_type>(other_base))
@@ -694,7 +1986,9 @@ namespace red_black_tree {
 	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
 	[[nodiscard]] constexpr auto equal_range(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
 	{
-		return std::pair{ lower_bound<tree_type>(base, root, value, less), upper_bound<tree_type>(base, root, value, less) };
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		auto [lower, upper] = detail::do_equal_range(node_type{ base, root }, value, less);
+		return std::pair{ forward_iter<tree_type, base_type>{ base, lower.root }, forward_iter<tree_type, base_type>{ base, upper.root } };
 	}
 
 	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
@@ -704,12 +1998,72 @@ namespace red_black_tree {
 		return detail::do_validate(node_type{ first, root }, std::distance(first, last), less);
 	}
 
+	/* Validates the tree like the other overloads, but checks each node only against its parent, its children and the key bounds of its ancestors, so the
+	 * subtrees of the top levels levels of the tree are checked through fork(f, g), for example on a thread pool. fork must return after both have run.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type, typename fork_type>
+	[[nodiscard]] constexpr auto validate(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, less_type less, typename std::iterator_traits<base_type>::difference_type levels, fork_type fork) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		return detail::do_validate(node_type{ first, root }, node_type{}, node_type{}, node_type{}, difference_type{}, difference_type(std::distance(first, last)), less, levels, fork) > 0;
+	}
+
 	template <typename tree_type, std::ranges::random_access_range rng, typename less_type>
 	[[nodiscard]] constexpr auto validate(rng r, typename std::iterator_traits<std::ranges::iterator_t<rng>>::difference_type root, less_type less) noexcept
 	{
 		using node_type = detail::red_black_tree_node<tree_type, std::ranges::iterator_t<rng>>;
 		return detail::do_validate(node_type{ std::begin(r), root }, std::distance(std::begin(r), std::end(r)), less);
 	}
+
+	template <typename tree_type, std::ranges::random_access_range rng, typename less_type, typename fork_type>
+	[[nodiscard]] constexpr auto validate(rng r, typename std::iterator_traits<std::ranges::iterator_t<rng>>::difference_type root, less_type less, typename std::iterator_traits<std::ranges::iterator_t<rng>>::difference_type levels, fork_type fork) noexcept
+	{
+		return validate<tree_type>(std::begin(r), std::end(r), root, less, levels, fork);
+	}
+
+	/* Checks the nodes at [first_link, last_link) and root in O(k log n) for k links, rather than the whole tree. If the tree was valid before some slots
+	 * changed, as after patch::apply_patch, it is valid after them when the links cover the changed slots and their neighbours from before the change.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::input_iterator link_iter, typename less_type>
+	[[nodiscard]] constexpr auto validate_nodes(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, link_iter first_link, link_iter last_link, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		const auto extent = difference_type(std::distance(first, last));
+		auto black_height = difference_type{};
+		auto depth = difference_type{};
+		for (auto curr = node_type{ first, root }; curr; curr = curr.left()) {
+			if (++depth > 2 * difference_type(std::bit_width(std::make_unsigned_t<difference_type>(extent))) + 1 or not detail::check_index(curr, extent))
+				return false;
+			black_height += detail::color::black == curr.color();
+		}
+		if (root and not detail::do_validate_node(node_type{ first, root }, node_type{ first, root }, extent, black_height, less))
+			return false;
+		for (; first_link not_eq last_link; ++first_link)
+			if (not detail::do_validate_node(node_type{ first, difference_type(*first_link) }, node_type{ first, root }, extent, black_height, less))
+				return false;
+		return true;
+	}
+
+	/* Writes the parent and children of the nodes at [first_link, last_link) to out and returns it, to be passed to validate_nodes along with the links.
+	 * Links outside [first, last) are skipped.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::input_iterator link_iter, typename out_type>
+	constexpr auto neighbours(base_type first, base_type last, link_iter first_link, link_iter last_link, out_type out) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::red_black_tree_node<tree_type, base_type>;
+		for (; first_link not_eq last_link; ++first_link) {
+			auto x = node_type{ first, difference_type(*first_link) };
+			if (not detail::check_index(x, std::distance(first, last)))
+				continue;
+			for (auto y : std::array{ x.parent(), x.left(), x.right() })
+				if (y)
+					*out++ = difference_type(y);
+		}
+		return out;
+	}
 }
 
 #endif
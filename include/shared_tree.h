@@ -0,0 +1,198 @@
+#if not defined(F47A1C9E3B6D4D28A05E7C2B91D4E6F3)
+#define F47A1C9E3B6D4D28A05E7C2B91D4E6F3
+#if defined(F47A1C9E3B6D4D28A05E7C2B91D4E6F3)
+
+#include "red_black_tree.h"
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+/* A red_black_tree shared between one writer and any number of readers, which may be other processes mapping the same memory, such as a memfd or shm_open
+ * mapping holding a header followed by the range of nodes. The writer brackets every change with the sequence counter of the header, which is odd while a
+ * change is under way, and readers run optimistically without taking any lock: read calls a function with the root, and calls it again whenever the sequence
+ * was odd or moved while it ran, so only a result computed from an image no writer touched is returned.
+ *
+ * While a reader races the writer it can meet any mixture of old and new links, so the descents here check every link against the range before following it
+ * and take no more steps than there are nodes, which turns a torn image into a failed read instead of a fault or an endless loop. A reader must copy what it
+ * needs out of the nodes inside the function it passes to read, since nothing outside it is protected, and nodes have to be trivially copyable so a torn
+ * read of one is harmless. A failed check under an unchanged sequence means the shared image itself is corrupt, and is returned rather than retried.
+*/
+namespace shared_tree {
+	// Constructed in place by the process that creates the mapping, then reached by the others through a pointer to the same bytes.
+	template <std::signed_integral difference_type>
+	struct header
+	{
+		std::atomic<std::uint64_t> sequence;
+		std::atomic<difference_type> root;
+		std::atomic<difference_type> size;
+
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free and std::atomic<difference_type>::is_always_lock_free, "shared memory needs address free atomics");
+	};
+
+	namespace detail {
+		template <typename tree_type, std::random_access_iterator base_type>
+		using node_type = red_black_tree::detail::red_black_tree_node<tree_type, base_type>;
+
+		// Whether curr is null or a node of the range.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto check_link(node_type<tree_type, base_type> curr, typename std::iterator_traits<base_type>::difference_type extent) noexcept
+		{
+			using T = typename std::iterator_traits<base_type>::difference_type;
+			return T{} <= T(curr) and T(curr) <= extent;
+		}
+
+		// The lowest node of the subtree at x not ordered before value, or after it when upper is set, and whether every link on the way was in range.
+		template <bool upper, typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_bound(node_type<tree_type, base_type> x, const V& value, typename std::iterator_traits<base_type>::difference_type extent, less_type& less) noexcept
+		{
+			auto z = node_type<tree_type, base_type>{};
+			auto p = red_black_tree::detail::value_prefix<tree_type>(value);
+			for (auto steps = extent; x;) {
+				if (not detail::check_link(x, extent) or steps-- == 0)
+					return std::pair{ z, false };
+				if (upper ? red_black_tree::detail::before_node(less, value, p, x) : not red_black_tree::detail::node_before(less, x, value, p)) {
+					z = x;
+					x = x.left();
+				} else
+					x = x.right();
+			}
+			return std::pair{ z, true };
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_min(node_type<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type extent) noexcept
+		{
+			for (auto steps = extent; x.left(); x = x.left())
+				if (not detail::check_link(x.left(), extent) or steps-- == 0)
+					return std::pair{ x, false };
+			return std::pair{ x, true };
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_successor(node_type<tree_type, base_type> x, typename std::iterator_traits<base_type>::difference_type extent) noexcept
+		{
+			if (x.right())
+				return detail::check_link(x.right(), extent) ? detail::do_min(x.right(), extent) : std::pair{ x, false };
+			auto steps = extent;
+			for (auto y = x.parent(); detail::check_link(y, extent) and steps-- not_eq 0; x = y, y = y.parent())
+				if (not y or x not_eq y.right())
+					return std::pair{ y, true };
+			return std::pair{ x, false };
+		}
+	}
+
+	// Marks the start of a change; readers that overlap it retry.
+	template <std::signed_integral difference_type>
+	auto begin_write(header<difference_type>& h) noexcept
+	{
+		h.sequence.store(h.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	// Publishes the change begun by begin_write.
+	template <std::signed_integral difference_type>
+	auto end_write(header<difference_type>& h) noexcept
+	{
+		h.sequence.store(h.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Inserts the node at it into the shared tree of the nodes at base and returns an iterator to it, for the one writer only.
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	auto insert(header<typename std::iterator_traits<base_type>::difference_type>& h, base_type base, base_type it, less_type less) noexcept
+	{
+		shared_tree::begin_write(h);
+		h.root.store(red_black_tree::insert<tree_type>(base, h.root.load(std::memory_order_relaxed), it, less), std::memory_order_relaxed);
+		h.size.store(h.size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		shared_tree::end_write(h);
+		return red_black_tree::make_iterator<tree_type>(base, it);
+	}
+
+	// Erases the node at it from the shared tree, for the one writer only. The node is free to reuse once erase returns, because readers that saw it retry.
+	template <typename tree_type, std::random_access_iterator base_type>
+	auto erase(header<typename std::iterator_traits<base_type>::difference_type>& h, red_black_tree::forward_iter<tree_type, base_type> it) noexcept
+	{
+		shared_tree::begin_write(h);
+		h.root.store(red_black_tree::erase<tree_type>(h.root.load(std::memory_order_relaxed), it), std::memory_order_relaxed);
+		h.size.store(h.size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		shared_tree::end_write(h);
+	}
+
+	/* Calls f once with the root and size of the tree and returns its result and whether it holds, which it doesn't if a change was under way or finished
+	 * while f ran.
+	*/
+	template <std::signed_integral difference_type, typename function_type>
+	auto try_read(const header<difference_type>& h, function_type&& f)
+	{
+		auto sequence = h.sequence.load(std::memory_order_acquire);
+		auto result = f(h.root.load(std::memory_order_relaxed), h.size.load(std::memory_order_relaxed));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return std::pair{ std::move(result), sequence % 2 == 0 and sequence == h.sequence.load(std::memory_order_relaxed) };
+	}
+
+	// Calls f with the root and size of the tree until it runs without a change overlapping it, and returns that result.
+	template <std::signed_integral difference_type, typename function_type>
+	auto read(const header<difference_type>& h, function_type&& f)
+	{
+		for (;;)
+			if (auto [result, held] = shared_tree::try_read(h, f); held)
+				return std::move(result);
+	}
+
+	/* The checked queries for readers, each returning a link, 0 for end, and whether every link followed was in [first, last). Nodes are read in place, so
+	 * they belong inside the function passed to read.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto lower_bound(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto [x, ok] = detail::do_bound<false>(detail::node_type<tree_type, base_type>{ first, root }, value, std::distance(first, last), less);
+		return std::pair{ x.root, ok };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto upper_bound(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto [x, ok] = detail::do_bound<true>(detail::node_type<tree_type, base_type>{ first, root }, value, std::distance(first, last), less);
+		return std::pair{ x.root, ok };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto find(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto [x, ok] = shared_tree::lower_bound<tree_type>(first, last, root, value, less);
+		if (x and red_black_tree::detail::before(less, value, detail::node_type<tree_type, base_type>{ first, x }.key()))
+			x = {};
+		return std::pair{ x, ok };
+	}
+
+	// The link of the lowest node, to start iterating with next.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto begin(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+		auto extent = std::distance(first, last);
+		if (not detail::check_link(detail::node_type<tree_type, base_type>{ first, root }, extent))
+			return std::pair{ difference_type{}, false };
+		if (not root)
+			return std::pair{ difference_type{}, true };
+		auto [x, ok] = detail::do_min(detail::node_type<tree_type, base_type>{ first, root }, extent);
+		return std::pair{ x.root, ok };
+	}
+
+	// The link after link, a node in the tree, in order.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto next(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type link) noexcept
+	{
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+		auto extent = std::distance(first, last);
+		if (not link or not detail::check_link(detail::node_type<tree_type, base_type>{ first, link }, extent))
+			return std::pair{ difference_type{}, false };
+		auto [x, ok] = detail::do_successor(detail::node_type<tree_type, base_type>{ first, link }, extent);
+		return std::pair{ x.root, ok };
+	}
+}
+
+#endif
+#endif
@@ -5,6 +5,7 @@
 #include "intrusive.h"
 #include <iterator>
 #include <limits>
+#include <utility>
 
 namespace single_list {
 	namespace detail {
@@ -218,6 +219,26 @@ namespace single_list {
 		return std::distance(begin<list_type>(base, root), end<list_type>(base));
 	}
 
+	// Writes the links of the list from head to out in order and returns out.
+	template <typename list_type, std::random_access_iterator base_type, typename out_type>
+	constexpr auto flatten(base_type base, typename std::iterator_traits<base_type>::difference_type head, out_type out) noexcept
+	{
+		for (auto x = detail::single_list_node<list_type, base_type>{ base, head }; x; x = x.next())
+			*out++ = x.link;
+		return out;
+	}
+
+	// Also writes project(element) of every element to values in the same order, and returns both output iterators.
+	template <typename list_type, std::random_access_iterator base_type, typename out_type, typename value_out, typename project_type>
+	constexpr auto flatten(base_type base, typename std::iterator_traits<base_type>::difference_type head, out_type out, value_out values, project_type project) noexcept
+	{
+		for (auto x = detail::single_list_node<list_type, base_type>{ base, head }; x; x = x.next()) {
+			*out++ = x.link;
+			*values++ = project(base[x.link - 1]);
+		}
+		return std::pair{ out, values };
+	}
+
 	template <typename list_type, std::random_access_iterator base_type>
 	[[nodiscard]] constexpr auto node_swap(typename std::iterator_traits<base_type>::difference_type head, forward_iter<list_type, base_type> a_prev, forward_iter<list_type, base_type> b_prev) noexcept
 	{
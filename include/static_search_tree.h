@@ -0,0 +1,138 @@
+#if not defined(E597B321F6CB448592133C13B2BDC8B7)
+#define E597B321F6CB448592133C13B2BDC8B7
+#if defined(E597B321F6CB448592133C13B2BDC8B7)
+
+#include "red_black_tree.h"
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* A read only snapshot of a red_black_tree as an implicit B-tree of block_size keys per node, stored in a separate key array with a parallel array of the
+ * links of the elements in the original range. Node k has its keys at [k * block_size, (k + 1) * block_size) and its children at k * (block_size + 1) + i + 1,
+ * so a search follows no links and touches one or two cache lines per level. Unused slots at the end hold the largest key and a null link. Searching
+ * std::int32_t keys compares a whole node at once with SSE2 or AVX2 when the compiler targets them and the search isn't constant evaluated.
+*/
+namespace static_search_tree {
+	inline constexpr auto block_size = std::ptrdiff_t{ 16 };
+
+	// The number of key and link slots needed for a tree of n elements.
+	[[nodiscard]] constexpr auto capacity(std::ptrdiff_t n) noexcept
+	{
+		return (n + block_size - 1) / block_size * block_size;
+	}
+
+	namespace detail {
+		[[nodiscard]] constexpr auto child(std::ptrdiff_t k, std::ptrdiff_t i) noexcept
+		{
+			return k * (block_size + 1) + i + 1;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator key_iter, std::random_access_iterator index_iter, typename project_type>
+		constexpr auto fill(std::ptrdiff_t k, std::ptrdiff_t blocks, red_black_tree::forward_iter<tree_type, base_type>& it, key_iter keys, index_iter indices, project_type& project) noexcept
+		{
+			using key_type = std::iter_value_t<key_iter>;
+			using node_type = red_black_tree::detail::red_black_tree_node<tree_type, base_type>;
+			if (k >= blocks)
+				return;
+			for (auto i = std::ptrdiff_t{}; i < block_size; ++i) {
+				detail::fill(detail::child(k, i), blocks, it, keys, indices, project);
+				if (it.root) {
+					keys[k * block_size + i] = project(node_type{ it.base, it.root }.key());
+					indices[k * block_size + i] = it.root;
+					++it;
+				} else {
+					keys[k * block_size + i] = std::numeric_limits<key_type>::max();
+					indices[k * block_size + i] = 0;
+				}
+			}
+			detail::fill(detail::child(k, block_size), blocks, it, keys, indices, project);
+		}
+
+		// The number of keys of node k that are less than value, which is also the slot of the first one that isn't.
+		template <std::random_access_iterator key_iter>
+		[[nodiscard]] constexpr auto rank_in_block(key_iter keys, std::ptrdiff_t k, const std::iter_value_t<key_iter>& value) noexcept
+		{
+#if defined(__SSE2__)
+			if constexpr (std::contiguous_iterator<key_iter> and std::is_same_v<std::iter_value_t<key_iter>, std::int32_t>) {
+				if (not std::is_constant_evaluated()) {
+					auto p = std::to_address(keys + k * block_size);
+#if defined(__AVX2__)
+					const auto x = _mm256_set1_epi32(value);
+					const auto lo = _mm256_cmpgt_epi32(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+					const auto hi = _mm256_cmpgt_epi32(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+					return std::ptrdiff_t(std::popcount(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(lo)))) + std::popcount(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(hi)))));
+#else
+					const auto x = _mm_set1_epi32(value);
+					auto mask = 0u;
+					for (auto i = 0; i < block_size / 4; ++i)
+						mask |= unsigned(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4 * i)))))) << (4 * i);
+					return std::ptrdiff_t(std::popcount(mask));
+#endif
+				}
+			}
+#endif
+			auto n = std::ptrdiff_t{};
+			for (auto i = std::ptrdiff_t{}; i < block_size; ++i)
+				n += keys[k * block_size + i] < value;
+			return n;
+		}
+
+		// Returns the slot of the first key that isn't less than value, or -1.
+		template <std::random_access_iterator key_iter>
+		[[nodiscard]] constexpr auto do_lower_bound(key_iter keys, std::ptrdiff_t blocks, const std::iter_value_t<key_iter>& value) noexcept
+		{
+			auto slot = std::ptrdiff_t{ -1 };
+			for (auto k = std::ptrdiff_t{}; k < blocks; ) {
+				auto i = detail::rank_in_block(keys, k, value);
+				if (i < block_size)
+					slot = k * block_size + i;
+				k = detail::child(k, i);
+			}
+			return slot;
+		}
+	}
+
+	/* Writes the elements of the tree rooted at root to keys and indices, which need room for capacity(size) values each, and returns the number of slots used.
+	 * project turns a key of the tree into the key_type of keys, which must be totally ordered by < and have std::numeric_limits.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator key_iter, std::random_access_iterator index_iter, typename project_type>
+	constexpr auto build(base_type base, typename std::iterator_traits<base_type>::difference_type root, key_iter keys, index_iter indices, project_type project) noexcept
+	{
+		auto slots = capacity(std::ptrdiff_t(red_black_tree::size<tree_type>(base, root)));
+		auto it = red_black_tree::begin<tree_type>(base, root);
+		detail::fill(std::ptrdiff_t{}, slots / block_size, it, keys, indices, project);
+		return slots;
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator key_iter, std::random_access_iterator index_iter>
+	constexpr auto build(base_type base, typename std::iterator_traits<base_type>::difference_type root, key_iter keys, index_iter indices) noexcept
+	{
+		return build<tree_type>(base, root, keys, indices, [](const auto& key) { return std::iter_value_t<key_iter>(key); });
+	}
+
+	// Returns an iterator into the original tree to the first element whose key isn't less than value, or end. slots is the value returned by build.
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator key_iter, std::random_access_iterator index_iter>
+	[[nodiscard]] constexpr auto lower_bound(base_type base, key_iter keys, index_iter indices, std::ptrdiff_t slots, const std::iter_value_t<key_iter>& value) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		auto slot = detail::do_lower_bound(keys, slots / block_size, value);
+		return red_black_tree::forward_iter<tree_type, base_type>{ base, slot < 0 ? difference_type{} : difference_type(indices[slot]) };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, std::random_access_iterator key_iter, std::random_access_iterator index_iter>
+	[[nodiscard]] constexpr auto find(base_type base, key_iter keys, index_iter indices, std::ptrdiff_t slots, const std::iter_value_t<key_iter>& value) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		auto slot = detail::do_lower_bound(keys, slots / block_size, value);
+		return red_black_tree::forward_iter<tree_type, base_type>{ base, slot < 0 or value < keys[slot] ? difference_type{} : difference_type(indices[slot]) };
+	}
+}
+
+#endif
+#endif
@@ -0,0 +1,199 @@
+#if not defined(B81F5C3A9E064D7FA2C1E08D6B47F3A5)
+#define B81F5C3A9E064D7FA2C1E08D6B47F3A5
+#if defined(B81F5C3A9E064D7FA2C1E08D6B47F3A5)
+
+#include "intrusive.h"
+#include <atomic>
+#include <compare>
+#include <concepts>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/* Transactions over a range of nodes through an undo log, for structures kept in a mapped file that must survive a crash in the middle of an operation.
+ * A journal holds the range, a range of records with its capacity and the number of records in use, which all belong in the same mapping. begin(journal)
+ * returns an iterator over the range to pass as base to red_black_tree, double_list, single_list or any other structure here. Every bookkeeping field
+ * stored through get by the algorithms first has the old image of its node appended to the log, so any number of operations between two commits form one
+ * transaction.
+ *
+ * sync is called with each object that has to reach the file before the next step, which is a record before the count that publishes it, the count before
+ * the node is written, and the nodes logged before the count is cleared by commit. The default only orders the stores in memory; a sync that calls msync on
+ * the pages of its argument makes the log durable. rollback, and recover on a log found in a mapping at open, restore the old images in reverse, so they
+ * take time in the number of records however large the range is, and running them again after a crash part way through gives the same result.
+ *
+ * The log holds one record per store, or fewer when stores to one node follow each other, and has to have room for every store of a transaction. Once it is
+ * full, stores go ahead without a record so the operation under way still sees a consistent structure, but the transaction can no longer be rolled back,
+ * and a crash before the next commit leaves it half done. Only stores through get are logged, so objects changed any other way, or moved by relayout, are
+ * not.
+*/
+namespace undo_log {
+	template <typename value_type, std::signed_integral difference_type = std::ptrdiff_t>
+	struct record
+	{
+		difference_type link;
+		value_type value;
+	};
+
+	// Orders each step before the next without writing anything back.
+	struct fence final
+	{
+		template <typename T>
+		constexpr auto operator()(const T&) const noexcept
+		{
+			if (not std::is_constant_evaluated())
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+		}
+	};
+
+	template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename sync_type = fence>
+	struct journal
+	{
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+
+		base_type base;
+		base_type last;
+		record_iter records;
+		difference_type capacity;
+		difference_type* size;
+		sync_type sync;
+		bool overflowed;
+	};
+
+	namespace detail {
+		// Appends the image of the node at it before it changes, unless the last record already holds it or the log is full.
+		template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename sync_type>
+		constexpr auto log(journal<base_type, record_iter, sync_type>& j, base_type it) noexcept
+		{
+			auto& size = *j.size;
+			const auto link = std::distance(j.base, it) + 1;
+			if (j.overflowed or (size and j.records[size - 1].link == link))
+				return;
+			if (size == j.capacity) {
+				j.overflowed = true;
+				return;
+			}
+			j.records[size].link = link;
+			j.records[size].value = *it;
+			j.sync(j.records[size]);
+			++size;
+			j.sync(size);
+		}
+
+		template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename difference_type, typename sync_type>
+		constexpr auto do_rollback(base_type first, base_type last, record_iter records, difference_type& size, sync_type& sync) noexcept
+		{
+			for (auto i = size; i-- > 0; )
+				if (auto link = records[i].link; 0 < link and link <= std::distance(first, last)) {
+					first[link - 1] = records[i].value;
+					sync(first[link - 1]);
+				}
+			size = 0;
+			sync(size);
+		}
+
+		template <typename T, typename journal_type>
+		struct field final
+		{
+			using base_type = decltype(std::declval<journal_type>().base);
+
+			journal_type* journal;
+			base_type it;
+			[[nodiscard]] explicit constexpr operator T() const noexcept { return T(intrusive::_get<T>(*it)); }
+			constexpr auto operator=(const T& t) const noexcept -> const field&
+			{
+				detail::log(*journal, it);
+				intrusive::_get<T>(*it) = t;
+				return *this;
+			}
+		};
+
+		// What the journaling iterator refers to, whose get returns fields that log their node before storing to it.
+		template <typename journal_type>
+		struct element final
+		{
+			using base_type = decltype(std::declval<journal_type>().base);
+
+			journal_type* journal;
+			base_type it;
+			template <typename T>
+			requires intrusive::detail::has_get<T, std::iter_value_t<base_type>>
+			[[nodiscard]] constexpr auto get() const noexcept { return field<T, journal_type>{ journal, it }; }
+		};
+	}
+
+	template <typename journal_type>
+	struct iterator final
+	{
+		using base_type = decltype(std::declval<journal_type>().base);
+		using value_type = detail::element<journal_type>;
+		using reference = detail::element<journal_type>;
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+		using iterator_category = std::random_access_iterator_tag;
+
+		journal_type* journal;
+		base_type it;
+		[[nodiscard]] constexpr auto operator*() const noexcept { return reference{ journal, it }; }
+		[[nodiscard]] constexpr auto operator[](difference_type n) const noexcept { return reference{ journal, it + n }; }
+		// The object itself, for anything other than its bookkeeping, which is not logged.
+		[[nodiscard]] constexpr auto operator->() const noexcept { return std::to_address(it); }
+		constexpr auto operator++() noexcept -> iterator& { ++it; return *this; }
+		constexpr auto operator--() noexcept -> iterator& { --it; return *this; }
+		[[nodiscard]] constexpr auto operator++(int) noexcept { auto copy = *this; ++it; return copy; }
+		[[nodiscard]] constexpr auto operator--(int) noexcept { auto copy = *this; --it; return copy; }
+		constexpr auto operator+=(difference_type n) noexcept -> iterator& { it += n; return *this; }
+		constexpr auto operator-=(difference_type n) noexcept -> iterator& { it -= n; return *this; }
+		[[nodiscard]] constexpr auto operator+(difference_type n) const noexcept { return iterator{ journal, it + n }; }
+		[[nodiscard]] friend constexpr auto operator+(difference_type n, const iterator& i) noexcept { return i + n; }
+		[[nodiscard]] constexpr auto operator-(difference_type n) const noexcept { return iterator{ journal, it - n }; }
+		[[nodiscard]] constexpr auto operator-(const iterator& other) const noexcept { return it - other.it; }
+		[[nodiscard]] constexpr auto operator==(const iterator& other) const noexcept { return it == other.it; }
+		[[nodiscard]] constexpr auto operator<=>(const iterator& other) const noexcept { return it <=> other.it; }
+	};
+
+	// The start of the range of j, through which stores are logged.
+	template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename sync_type>
+	[[nodiscard]] constexpr auto begin(journal<base_type, record_iter, sync_type>& j) noexcept
+	{
+		return iterator<journal<base_type, record_iter, sync_type>>{ std::addressof(j), j.base };
+	}
+
+	// Undoes every store since the last commit and returns true, or returns false and changes nothing if the log overflowed.
+	template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename sync_type>
+	constexpr auto rollback(journal<base_type, record_iter, sync_type>& j) noexcept
+	{
+		if (j.overflowed)
+			return false;
+		detail::do_rollback(j.base, j.last, j.records, *j.size, j.sync);
+		return true;
+	}
+
+	/* Makes every store since the last commit durable and empties the log. Returns whether the transaction was protected throughout, which it wasn't if the
+	 * log overflowed, when the whole range is synced instead since the nodes changed since aren't known.
+	*/
+	template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename sync_type>
+	constexpr auto commit(journal<base_type, record_iter, sync_type>& j) noexcept
+	{
+		using difference_type = typename std::iterator_traits<base_type>::difference_type;
+		const auto overflowed = std::exchange(j.overflowed, false);
+		if (overflowed)
+			for (auto it = j.base; it not_eq j.last; ++it)
+				j.sync(*it);
+		else
+			for (auto i = difference_type{}; i < *j.size; ++i)
+				j.sync(j.base[j.records[i].link - 1]);
+		*j.size = 0;
+		j.sync(*j.size);
+		return not overflowed;
+	}
+
+	// Rolls back the transaction left in a log by a crash, given the range, the records and their count as found in the mapping.
+	template <std::random_access_iterator base_type, std::random_access_iterator record_iter, typename difference_type, typename sync_type = fence>
+	constexpr auto recover(base_type first, base_type last, record_iter records, difference_type& size, sync_type sync = {}) noexcept
+	{
+		detail::do_rollback(first, last, records, size, sync);
+	}
+}
+
+#endif
+#endif
@@ -0,0 +1,484 @@
+#if not defined(E0A8D5F27C3B4E9196B4A1D6C3F58E27)
+#define E0A8D5F27C3B4E9196B4A1D6C3F58E27
+#if defined(E0A8D5F27C3B4E9196B4A1D6C3F58E27)
+
+#include "intrusive.h"
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+/* A weak AVL tree, with the same interface as red_black_tree. tree_type provides left_type, right_type, parent_type and key_type like red_black_tree, and a
+ * parity_type in place of color_type, explicitly convertible to and from bool, which holds the parity of the rank of a node. Every rank difference is 1 or
+ * 2, so whether the parities of a node and its child differ is enough to tell them apart, with null nodes having rank -1. Insertion rebalances like an AVL
+ * tree, so a tree built by insertions alone is one, and erasure does at most two rotations, with O(1) amortized rank changes per update.
+*/
+namespace wavl_tree {
+	namespace detail {
+		template <typename tree_type, std::random_access_iterator base_type>
+		struct wavl_tree_node final
+		{
+			base_type base;
+			using parity_type = typename tree_type::parity_type;
+			using left_type = typename tree_type::left_type;
+			using right_type = typename tree_type::right_type;
+			using parent_type = typename tree_type::parent_type;
+			using key_type = typename tree_type::key_type;
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+
+			difference_type root;
+			[[nodiscard]] constexpr auto left() const noexcept { return wavl_tree_node{ base, difference_type(left_type(intrusive::_get<left_type>(base[root - 1]))) }; }
+			[[nodiscard]] constexpr auto right() const noexcept { return wavl_tree_node{ base, difference_type(right_type(intrusive::_get<right_type>(base[root - 1]))) }; }
+			[[nodiscard]] constexpr auto parent() const noexcept { return wavl_tree_node{ base, difference_type(parent_type(intrusive::_get<parent_type>(base[root - 1]))) }; }
+			// Null nodes have rank -1, which is odd.
+			[[nodiscard]] constexpr auto parity() const noexcept { return not root or bool(parity_type(intrusive::_get<parity_type>(base[root - 1]))); }
+
+			constexpr auto left(const wavl_tree_node& left) const noexcept { intrusive::_get<left_type>(base[root - 1]) = left_type(left.root); }
+			constexpr auto right(const wavl_tree_node& right) const noexcept { intrusive::_get<right_type>(base[root - 1]) = right_type(right.root); }
+			constexpr auto parent(const wavl_tree_node& parent) const noexcept { intrusive::_get<parent_type>(base[root - 1]) = parent_type(parent.root); }
+			constexpr auto parity(bool parity) const noexcept { intrusive::_get<parity_type>(base[root - 1]) = parity_type(parity); }
+			// Promoting or demoting a node flips the parity of its rank.
+			constexpr auto flip() const noexcept { parity(not parity()); }
+			[[nodiscard]] constexpr decltype(auto) key() const noexcept
+			{
+				if constexpr (std::is_same_v<key_type, std::remove_cvref_t<decltype(intrusive::_get<key_type>(*std::declval<base_type>()))>>)
+					return intrusive::_get<key_type>(base[root - 1]);
+				else
+					return key_type(intrusive::_get<key_type>(base[root - 1]));
+			}
+			[[nodiscard]] constexpr auto operator==(const wavl_tree_node& other) const noexcept { return root == other.root; }
+			[[nodiscard]] constexpr auto operator!=(const wavl_tree_node& other) const noexcept { return root not_eq other.root; }
+			[[nodiscard]] explicit constexpr operator bool() const noexcept { return bool(root); }
+			[[nodiscard]] explicit constexpr operator difference_type() const noexcept { return root; }
+		};
+
+		// Whether x, a child of p, has a rank difference of 2 rather than 1, or of 0 rather than 1 right after x was promoted.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto even(const wavl_tree_node<tree_type, base_type> x, const wavl_tree_node<tree_type, base_type> p) noexcept
+		{
+			return x.parity() == p.parity();
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto left_rotate(wavl_tree_node<tree_type, base_type> root, const wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			const auto y = x.right();
+			x.right(y.left());
+			if (y.left())
+				y.left().parent(x);
+			y.parent(x.parent());
+			if (not x.parent())
+				root = y;
+			else if (x == x.parent().left())
+				x.parent().left(y);
+			else
+				x.parent().right(y);
+			y.left(x);
+			x.parent(y);
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto right_rotate(wavl_tree_node<tree_type, base_type> root, const wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			const auto y = x.left();
+			x.left(y.right());
+			if (y.right())
+				y.right().parent(x);
+			y.parent(x.parent());
+			if (not x.parent())
+				root = y;
+			else if (x == x.parent().left())
+				x.parent().left(y);
+			else
+				x.parent().right(y);
+			y.right(x);
+			x.parent(y);
+			return root;
+		}
+
+		// x was just inserted or promoted. While it is a 0-child, promote its parent if the sibling is a 1-child, otherwise rotate once or twice and stop.
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto insert_fixup(wavl_tree_node<tree_type, base_type> root, wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			for (auto p = x.parent(); p and detail::even(x, p); p = x.parent()) {
+				const auto left = p.left() == x;
+				const auto s = left ? p.right() : p.left();
+				if (not detail::even(s, p)) {
+					p.flip();
+					x = p;
+					continue;
+				}
+				const auto y = left ? x.right() : x.left();
+				if (detail::even(y, x)) {
+					root = left ? detail::right_rotate(root, p) : detail::left_rotate(root, p);
+					p.flip();
+				} else {
+					root = left ? detail::left_rotate(root, x) : detail::right_rotate(root, x);
+					root = left ? detail::right_rotate(root, p) : detail::left_rotate(root, p);
+					y.flip();
+					x.flip();
+					p.flip();
+				}
+				break;
+			}
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_insert(wavl_tree_node<tree_type, base_type> root, wavl_tree_node<tree_type, base_type> z, less_type less) noexcept
+		{
+			auto y = wavl_tree_node<tree_type, base_type>{};
+			auto left = false;
+			for (auto x = root; x; x = left ? x.left() : x.right()) {
+				y = x;
+				left = less(z.key(), x.key());
+			}
+			z.parity(false);
+			z.left(wavl_tree_node<tree_type, base_type>{});
+			z.right(wavl_tree_node<tree_type, base_type>{});
+			z.parent(y);
+			if (not y)
+				return z;
+			if (left)
+				y.left(z);
+			else
+				y.right(z);
+			return detail::insert_fixup(root, z);
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto min(wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			while (x.left())
+				x = x.left();
+			return x;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto max(wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			while (x.right())
+				x = x.right();
+			return x;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto successor(wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			if (x.right())
+				return detail::min(x.right());
+			auto y = x.parent();
+			while (y and x == y.right()) {
+				x = y;
+				y = y.parent();
+			}
+			return y;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto predecessor(wavl_tree_node<tree_type, base_type> x) noexcept
+		{
+			if (x.left())
+				return detail::max(x.left());
+			auto y = x.parent();
+			while (y and x == y.left()) {
+				x = y;
+				y = y.parent();
+			}
+			return y;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_node_relink(wavl_tree_node<tree_type, base_type> root, const wavl_tree_node<tree_type, base_type> out_of_tree, const wavl_tree_node<tree_type, base_type> in_tree) noexcept
+		{
+			if (in_tree.parent()) {
+				if (in_tree.parent().left() == in_tree)
+					in_tree.parent().left(out_of_tree);
+				else
+					in_tree.parent().right(out_of_tree);
+			}
+			if (in_tree.left())
+				in_tree.left().parent(out_of_tree);
+			if (in_tree.right())
+				in_tree.right().parent(out_of_tree);
+			if (root == in_tree)
+				root = out_of_tree;
+			out_of_tree.parity(in_tree.parity());
+			out_of_tree.left(in_tree.left());
+			out_of_tree.right(in_tree.right());
+			out_of_tree.parent(in_tree.parent());
+			return root;
+		}
+
+		/* x, which may be null, is a 3-child of p. While its sibling is a 2-child, or a 1-child whose children are both 2-children, demote p, and the sibling
+		 * with it in the second case, and carry on from p if that made it a 3-child. Otherwise one or two rotations finish.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto erase_fixup(wavl_tree_node<tree_type, base_type> root, wavl_tree_node<tree_type, base_type> x, wavl_tree_node<tree_type, base_type> p) noexcept
+		{
+			for (auto three = true; three; x = p, p = p.parent()) {
+				const auto left = p.left() == x;
+				const auto s = left ? p.right() : p.left();
+				const auto t = left ? s.left() : s.right();
+				const auto u = left ? s.right() : s.left();
+				if (detail::even(s, p) or (detail::even(t, s) and detail::even(u, s))) {
+					three = p.parent() and detail::even(p, p.parent());
+					if (not detail::even(s, p))
+						s.flip();
+					p.flip();
+					continue;
+				}
+				if (not detail::even(u, s)) {
+					root = left ? detail::left_rotate(root, p) : detail::right_rotate(root, p);
+					s.flip();
+					if (p.left() or p.right())
+						p.flip();
+				} else {
+					root = left ? detail::right_rotate(root, s) : detail::left_rotate(root, s);
+					root = left ? detail::left_rotate(root, p) : detail::right_rotate(root, p);
+					s.flip();
+				}
+				break;
+			}
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto do_erase(wavl_tree_node<tree_type, base_type> root, const wavl_tree_node<tree_type, base_type> z) noexcept
+		{
+			const auto y = z.left() and z.right() ? detail::successor(z) : z;
+			const auto x = y.left() ? y.left() : y.right();
+			auto p = y.parent();
+			const auto three = p and detail::even(y, p);
+			if (not p)
+				root = x;
+			else if (p.left() == y)
+				p.left(x);
+			else
+				p.right(x);
+			if (x)
+				x.parent(p);
+			if (y not_eq z) {
+				root = detail::do_node_relink(root, y, z);
+				if (p == z)
+					p = y;
+			}
+			if (three)
+				return detail::erase_fixup(root, x, p);
+			// A leaf left with two 2-children has rank 1, so demote it.
+			if (p and not p.left() and not p.right() and p.parity()) {
+				const auto above = p.parent() and detail::even(p, p.parent());
+				p.flip();
+				if (above)
+					return detail::erase_fixup(root, p, p.parent());
+			}
+			return root;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_lower_bound(wavl_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto z = wavl_tree_node<tree_type, base_type>{};
+			while (x)
+				if (not less(x.key(), value)) {
+					z = x;
+					x = x.left();
+				} else
+					x = x.right();
+			return z;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+		[[nodiscard]] constexpr auto do_upper_bound(wavl_tree_node<tree_type, base_type> x, const V& value, less_type less) noexcept
+		{
+			auto z = wavl_tree_node<tree_type, base_type>{};
+			while (x)
+				if (less(value, x.key())) {
+					z = x;
+					x = x.left();
+				} else
+					x = x.right();
+			return z;
+		}
+
+		template <typename tree_type, std::random_access_iterator base_type>
+		[[nodiscard]] constexpr auto check_index(wavl_tree_node<tree_type, base_type> curr, typename std::iterator_traits<base_type>::difference_type extent) noexcept
+		{
+			using T = typename std::iterator_traits<base_type>::difference_type;
+			return T{} < T(curr) and T(curr) <= extent;
+		}
+
+		/* Checks the subtree at x, whose parent must be parent and whose keys must be ordered between those of lo and hi where they aren't null, and returns its
+		 * rank, or -2 on failure. The rank follows from either child and the parities, so both children have to agree, and leaves must have rank 0.
+		*/
+		template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+		[[nodiscard]] constexpr auto do_validate(const wavl_tree_node<tree_type, base_type> x, const wavl_tree_node<tree_type, base_type> parent, const wavl_tree_node<tree_type, base_type> lo, const wavl_tree_node<tree_type, base_type> hi, typename std::iterator_traits<base_type>::difference_type depth, typename std::iterator_traits<base_type>::difference_type extent, less_type& less) noexcept -> typename std::iterator_traits<base_type>::difference_type
+		{
+			using difference_type = typename std::iterator_traits<base_type>::difference_type;
+			if (not x)
+				return -1;
+			if (depth > 2 * difference_type(std::bit_width(std::make_unsigned_t<difference_type>(extent))) or not detail::check_index(x, extent) or x.parent() not_eq parent)
+				return -2;
+			if (x.left() and x.left() == x.right())
+				return -2;
+			if ((lo and less(x.key(), lo.key())) or (hi and less(hi.key(), x.key())))
+				return -2;
+			auto l = detail::do_validate(x.left(), x, lo, x, depth + 1, extent, less);
+			if (l < -1)
+				return -2;
+			auto r = detail::do_validate(x.right(), x, x, hi, depth + 1, extent, less);
+			if (r < -1)
+				return -2;
+			auto rank = l + 2 - (x.left().parity() not_eq x.parity());
+			if (rank not_eq r + 2 - (x.right().parity() not_eq x.parity()))
+				return -2;
+			if (not x.left() and not x.right() and rank not_eq 0)
+				return -2;
+			return rank;
+		}
+	}
+
+	/* Implements a bidirectional iterator over the tree like red_black_tree::forward_iter, except end is not decrementable.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type>
+	struct forward_iter final
+	{
+		using value_type = std::iterator_traits<base_type>::value_type;
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using reference = std::iterator_traits<base_type>::reference;
+		using pointer = std::iterator_traits<base_type>::pointer;
+		using iterator_category = std::forward_iterator_tag;
+
+		base_type base;
+		std::iterator_traits<base_type>::difference_type root;
+		constexpr decltype(auto) operator++() noexcept
+		{
+			root = difference_type(detail::successor(detail::wavl_tree_node<tree_type, base_type>{ base, root }));
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator++(int) noexcept { auto copy = *this; ++(*this); return copy; }
+		constexpr decltype(auto) operator--() noexcept
+		{
+			root = difference_type(detail::predecessor(detail::wavl_tree_node<tree_type, base_type>{ base, root }));
+			return *this;
+		}
+		[[nodiscard]] constexpr auto operator--(int) noexcept { auto copy = *this; --(*this); return copy; }
+		[[nodiscard]] constexpr decltype(auto) operator*() const noexcept { return base[root - 1]; }
+		[[nodiscard]] constexpr auto operator->() const noexcept { return base + (root - 1); }
+		[[nodiscard]] constexpr decltype(auto) operator*() noexcept { return base[root - 1]; }
+		[[nodiscard]] constexpr auto operator->() noexcept { return base + (root - 1); }
+		template <typename other_base>
+		[[nodiscard]] constexpr auto operator==(const forward_iter<tree_type, other_base>& other) const noexcept { return root == other.root; }
+		template <typename other_base>
+		[[nodiscard]] constexpr auto operator!=(const forward_iter<tree_type, other_base>& other) const noexcept { return root not_eq other.root; }
+	};
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto end(base_type base) noexcept
+	{
+		return forward_iter<tree_type, base_type>{ base, {} };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto begin(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return root ? forward_iter<tree_type, base_type>{ base, difference_type(detail::min(node_type{ base, root })) } : end<tree_type>(base);
+	}
+
+	// Makes an iterator from a random access iterator and a base pointer. be careful that it points to an element of the structure, or will by the time it's used.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto make_iterator(base_type base, base_type it) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		return forward_iter<tree_type, base_type>{ base, difference_type(std::distance(base, it) + 1) };
+	}
+
+	/* Inserts an object pointed to by it into the structure rooted at root in the random access range at base. returns the new root.
+	 * There's no uniqueness guarantee; if you wish the tree to contain unique elements, check before inserting an element.
+	*/
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto insert(base_type base, typename std::iterator_traits<base_type>::difference_type root, base_type it, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return difference_type(detail::do_insert(node_type{ base, root }, node_type{ base, difference_type(std::distance(base, it) + 1) }, less));
+	}
+
+	// Erases an element it from the structure rooted at root in the random access range at base. returns the new root.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto erase(typename std::iterator_traits<base_type>::difference_type root, forward_iter<tree_type, base_type> it) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return difference_type(detail::do_erase(node_type{ it.base, root }, node_type{ it.base, it.root }));
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto upper_bound(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return forward_iter<tree_type, base_type>{ base, detail::do_upper_bound(node_type{ base, root }, value, less).root };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto lower_bound(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return forward_iter<tree_type, base_type>{ base, detail::do_lower_bound(node_type{ base, root }, value, less).root };
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename V, typename less_type>
+	[[nodiscard]] constexpr auto find(base_type base, typename std::iterator_traits<base_type>::difference_type root, const V& value, less_type less) noexcept
+	{
+		auto it = lower_bound<tree_type>(base, root, value, less);
+		return it == end<tree_type>(base) or less(value, detail::wavl_tree_node<tree_type, base_type>{ base, it.root }.key()) ? end<tree_type>(base) : it;
+	}
+
+	// Given a node in the tree src, and a node out of the tree dst, relink the tree so dst is in the tree where src was. Src's key must be the correct key for dst's position in the tree.
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto node_relink(typename std::iterator_traits<base_type>::difference_type root, base_type dst, forward_iter<tree_type, base_type> src) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return difference_type(detail::do_node_relink(node_type{ src.base, root }, node_type{ src.base, difference_type(std::distance(src.base, dst) + 1) }, node_type{ src.base, src.root }));
+	}
+
+	template <std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto empty(typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		return not root;
+	}
+
+	template <std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto max_size() noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		return difference_type(std::numeric_limits<difference_type>::max() - 1);
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type>
+	[[nodiscard]] constexpr auto size(base_type base, typename std::iterator_traits<base_type>::difference_type root) noexcept
+	{
+		return std::distance(begin<tree_type>(base, root), end<tree_type>(base));
+	}
+
+	template <typename tree_type, std::random_access_iterator base_type, typename less_type>
+	[[nodiscard]] constexpr auto validate(base_type first, base_type last, typename std::iterator_traits<base_type>::difference_type root, less_type less) noexcept
+	{
+		using difference_type = std::iterator_traits<base_type>::difference_type;
+		using node_type = detail::wavl_tree_node<tree_type, base_type>;
+		return detail::do_validate(node_type{ first, root }, node_type{}, node_type{}, node_type{}, difference_type{}, difference_type(std::distance(first, last)), less) >= -1;
+	}
+
+	template <typename tree_type, std::ranges::random_access_range rng, typename less_type>
+	[[nodiscard]] constexpr auto validate(rng r, typename std::iterator_traits<std::ranges::iterator_t<rng>>::difference_type root, less_type less) noexcept
+	{
+		return validate<tree_type>(std::begin(r), std::end(r), root, less);
+	}
+}
+
+#endif
+#endif
@@ -1,10 +1,20 @@
 #include "red_black_tree.h"
+#include "parentless_red_black_tree.h"
+#include "persistent_red_black_tree.h"
+#include "static_search_tree.h"
+#include "b_tree.h"
+#include "wavl_tree.h"
+#include "interval_tree.h"
+#include "shared_tree.h"
+#include "patch.h"
+#include "undo_log.h"
 #include "double_list.h"
 #include "single_list.h"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <compare>
 #include <cstdint>
 #include <cstring>
 #include <functional>
@@ -21,6 +31,134 @@ struct tree_type
 	enum class key_type : std::size_t {};
 };
 
+struct counted_tree_type : tree_type
+{
+	enum class count_type : std::size_t {};
+};
+
+struct prefixed_tree_type : tree_type
+{
+	enum class prefix_type : std::size_t {};
+	static constexpr auto prefix(key_type key) noexcept { return prefix_type(std::size_t(key) / 8); }
+};
+
+struct digested_tree_type : tree_type
+{
+	enum class digest_type : std::uint64_t {};
+	static constexpr auto digest(key_type key) noexcept
+	{
+		auto h = (std::uint64_t(key) + 1) * 0x9E3779B97F4A7C15u;
+		return h ^ (h >> 31);
+	}
+};
+
+struct aggregated_tree_type : tree_type
+{
+	// The first key of a range and the sum of its keys, so a range combined out of order or with a gap shows up.
+	struct aggregate_type
+	{
+		std::size_t first;
+		std::size_t sum;
+		constexpr auto operator==(const aggregate_type&) const noexcept -> bool = default;
+	};
+	static constexpr auto identity() noexcept { return aggregate_type{ std::size_t(-1), 0 }; }
+	static constexpr auto lift(const auto& node) noexcept
+	{
+		auto k = std::size_t(key_type(get<key_type>(node)));
+		return aggregate_type{ k, k };
+	}
+	static constexpr auto combine(const aggregate_type& a, const aggregate_type& b) noexcept { return aggregate_type{ a.first not_eq std::size_t(-1) ? a.first : b.first, a.sum + b.sum }; }
+};
+
+struct interval_type : tree_type
+{
+	enum class end_type : std::size_t {};
+	enum class max_end_type : std::size_t {};
+};
+
+struct packed_color_tree_type
+{
+	using left_type = tree_type::left_type;
+	using right_type = tree_type::right_type;
+	using parent_type = tree_type::parent_type;
+	using color_type = red_black_tree::packed_color<parent_type>;
+	using key_type = tree_type::key_type;
+};
+
+struct low_packed_color_tree_type
+{
+	enum class left_type : std::uint16_t {};
+	enum class right_type : std::uint16_t {};
+	enum class parent_type : std::uint16_t {};
+	using color_type = red_black_tree::packed_color<left_type, red_black_tree::color_bit::low>;
+	using key_type = tree_type::key_type;
+};
+
+struct parentless_tree_type
+{
+	using left_type = tree_type::left_type;
+	using right_type = tree_type::right_type;
+	using color_type = tree_type::color_type;
+	using key_type = tree_type::key_type;
+};
+
+struct persistent_tree_type : parentless_tree_type
+{
+	enum class refcount_type : std::size_t {};
+};
+
+struct wavl_tree_type
+{
+	using left_type = tree_type::left_type;
+	using right_type = tree_type::right_type;
+	using parent_type = tree_type::parent_type;
+	enum class parity_type : bool {};
+	using key_type = tree_type::key_type;
+};
+
+struct portable_tree_type
+{
+	using left_type = intrusive::le_u16_link<struct portable_left>;
+	using right_type = intrusive::le_u16_link<struct portable_right>;
+	using parent_type = intrusive::be_u16_link<struct portable_parent>;
+	using color_type = intrusive::color_byte<struct portable_color>;
+	using key_type = intrusive::le_key<std::int32_t>;
+};
+
+struct portable_node
+{
+	portable_tree_type::left_type left;
+	portable_tree_type::right_type right;
+	portable_tree_type::parent_type parent;
+	portable_tree_type::color_type color;
+	portable_tree_type::key_type key;
+
+	template <typename T>
+	[[nodiscard]] constexpr auto get() noexcept -> T& { return std::get<T&>(std::tie(left, right, parent, color, key)); }
+	template <typename T>
+	[[nodiscard]] constexpr auto get() const noexcept -> const T& { return std::get<const T&>(std::tie(left, right, parent, color, key)); }
+};
+
+struct packed_tree_type
+{
+	using left_type = intrusive::le_u24_link<struct packed_left>;
+	using right_type = intrusive::be_u40_link<struct packed_right>;
+	using parent_type = intrusive::le_u48_link<struct packed_parent>;
+	using color_type = intrusive::color_byte<struct packed_color>;
+	using key_type = int;
+};
+
+struct b_tree_type
+{
+	using key_type = tree_type::key_type;
+	enum class size_type : std::uint8_t {};
+	enum class level_type : std::uint8_t {};
+	enum class next_type : std::uint16_t {};
+	enum class prev_type : std::uint16_t {};
+	using keys_type = std::array<key_type, 4>;
+	using links_type = std::array<std::uint16_t, 4>;
+};
+
 struct list_type
 {
 	enum class next_type : std::size_t {};
@@ -95,6 +233,33 @@ constexpr auto get(example_list&& node)
 	return proxy<T, example_list&&>{node};
 };
 
+template <typename... Ts>
+struct tuple_node {std::tuple<Ts...> ts;};
+
+template <typename T, typename... Ts>
+constexpr auto get(const tuple_node<Ts...>& node)
+{
+	return proxy<T, const tuple_node<Ts...>&>{node};
+};
+
+template <typename T, typename... Ts>
+constexpr auto get(const tuple_node<Ts...>&& node)
+{
+	return proxy<T, const tuple_node<Ts...>&&>{node};
+};
+
+template <typename T, typename... Ts>
+constexpr auto get(tuple_node<Ts...>& node)
+{
+	return proxy<T, tuple_node<Ts...>&>{node};
+};
+
+template <typename T, typename... Ts>
+constexpr auto get(tuple_node<Ts...>&& node)
+{
+	return proxy<T, tuple_node<Ts...>&&>{node};
+};
+
 template <typename key_type>
 [[nodiscard]] constexpr auto init_tree_nodes(std::ranges::contiguous_range auto nodes) noexcept
 {
@@ -316,6 +481,1243 @@ template <typename key_type>
 	return true;
 }
 
+[[nodiscard]] constexpr auto test_tree_build() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	std::array<std::ptrdiff_t, 100> indices{};
+	using tree_key = typename tree_type::key_type;
+
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+
+	root = red_black_tree::build_sorted<tree_type>(std::span(nodes).begin(), std::span(nodes).begin(), std::span(nodes).begin());
+	assert_empty_tree<decltype(std::span(nodes).begin())>(root);
+
+	for (auto n : { std::ptrdiff_t{1}, std::ptrdiff_t{2}, std::ptrdiff_t{3}, std::ptrdiff_t{31}, std::ptrdiff_t{64}, std::ptrdiff_t{100} }) {
+		root = red_black_tree::build_sorted<tree_type>(std::span(nodes).begin(), std::span(nodes).begin(), std::span(nodes).begin() + n);
+		assert_valid_tree(std::span(nodes).first(std::size_t(n)), root);
+		assert_tree_size(std::span(nodes), root, n);
+		assert_tree_nodes_increase_addr(std::span(nodes).first(std::size_t(n)), root);
+	}
+
+	root = red_black_tree::build_sorted<tree_type>(std::span(nodes).begin(), std::span(nodes).begin() + 10, std::span(nodes).begin() + 60);
+	assert_valid_tree(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{50});
+	assert(std::ptrdiff_t(tree_key(get<tree_key>(*red_black_tree::begin<tree_type>(std::span(nodes).begin(), root)))) == 10);
+
+	for (auto& node : nodes)
+		get<tree_key>(node) = tree_key(std::ptrdiff_t(nodes.size()) - 1 - std::distance(nodes.data(), &node));
+
+	root = red_black_tree::build<tree_type>(std::span(nodes).begin(), std::span(nodes).begin(), std::span(nodes).end(), indices.begin(), std::less<>{});
+	assert_valid_tree(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{100});
+	std::for_each(red_black_tree::begin<tree_type>(std::span(nodes).begin(), root), red_black_tree::end<tree_type>(std::span(nodes).begin()), [&, i = nodes.size()](const auto& node) mutable
+	{
+		assert(&nodes[--i] == &node);
+	});
+
+	root = assert_remove_odd_tree_nodes(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{50});
+
+	return true;
+}
+
+template <typename key_type>
+[[nodiscard]] constexpr auto make_set_operation_trees(std::ranges::contiguous_range auto nodes) noexcept
+{
+	auto root = std::ptrdiff_t{};
+	auto other_root = std::ptrdiff_t{};
+	for (const auto& node : std::views::iota(nodes.begin(), nodes.begin() + 60)) {
+		get<key_type>(*node) = key_type(std::distance(nodes.begin(), node));
+		root = red_black_tree::insert<tree_type>(nodes.begin(), root, node, std::less<>{});
+	}
+	for (const auto& node : std::views::iota(nodes.begin() + 60, nodes.end())) {
+		get<key_type>(*node) = key_type(std::distance(nodes.begin() + 60, node) * 2 + 30);
+		other_root = red_black_tree::insert<tree_type>(nodes.begin(), other_root, node, std::less<>{});
+	}
+	return std::pair{ root, other_root };
+}
+
+template <typename key_type>
+constexpr auto assert_tree_keys(std::ranges::contiguous_range auto nodes, std::same_as<std::ptrdiff_t> auto root, auto pred) noexcept
+{
+	assert_valid_tree(nodes, root);
+	auto n = std::ptrdiff_t{};
+	for (auto k = std::ptrdiff_t{}; k < 110; ++k) {
+		auto it = red_black_tree::find<tree_type>(nodes.begin(), root, key_type(k), std::less<>{});
+		assert((it not_eq red_black_tree::end<tree_type>(nodes.begin())) == pred(k));
+		n += pred(k);
+	}
+	assert_tree_size(nodes, root, n);
+}
+
+[[nodiscard]] constexpr auto test_tree_set_operations() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto in_a = [](std::ptrdiff_t k) { return k < 60; };
+	auto in_b = [](std::ptrdiff_t k) { return k >= 30 and k < 110 and k % 2 == 0; };
+	auto reversed = [](auto&& f, auto&& g) { g(); f(); };
+
+	auto [root, other_root] = make_set_operation_trees<tree_key>(std::span(nodes));
+	auto [l, r] = red_black_tree::split<tree_type>(base, root, tree_key{25}, std::less<>{});
+	assert_tree_keys<tree_key>(std::span(nodes), l, [](std::ptrdiff_t k) { return k < 25; });
+	assert_tree_keys<tree_key>(std::span(nodes), r, [](std::ptrdiff_t k) { return k >= 25 and k < 60; });
+	r = red_black_tree::erase<tree_type>(r, red_black_tree::begin<tree_type>(base, r));
+	root = red_black_tree::join<tree_type>(base, l, base + 25, r);
+	assert_tree_keys<tree_key>(std::span(nodes), root, in_a);
+	std::tie(l, r) = red_black_tree::split<tree_type>(base, other_root, tree_key{0}, std::less<>{});
+	assert(l == 0 and r not_eq 0);
+	other_root = red_black_tree::join<tree_type>(base, l, base + 60, red_black_tree::erase<tree_type>(r, red_black_tree::begin<tree_type>(base, r)));
+	assert_tree_keys<tree_key>(std::span(nodes), other_root, in_b);
+
+	std::tie(root, other_root) = red_black_tree::set_union<tree_type>(base, root, other_root, std::less<>{});
+	assert_tree_keys<tree_key>(std::span(nodes), root, [&](std::ptrdiff_t k) { return in_a(k) or in_b(k); });
+	assert_tree_keys<tree_key>(std::span(nodes), other_root, [&](std::ptrdiff_t k) { return in_a(k) and in_b(k); });
+
+	std::tie(root, other_root) = make_set_operation_trees<tree_key>(std::span(nodes));
+	std::tie(root, other_root) = red_black_tree::set_intersection<tree_type>(base, root, other_root, std::less<>{}, std::ptrdiff_t{1}, reversed);
+	assert_tree_keys<tree_key>(std::span(nodes), root, [&](std::ptrdiff_t k) { return in_a(k) and in_b(k); });
+	assert(red_black_tree::size<tree_type>(base, other_root) == 85);
+	for (auto it = red_black_tree::begin<tree_type>(base, root); it not_eq red_black_tree::end<tree_type>(base); ++it)
+		assert(it.root <= 60);
+
+	std::tie(root, other_root) = make_set_operation_trees<tree_key>(std::span(nodes));
+	std::tie(root, other_root) = red_black_tree::set_difference<tree_type>(base, root, other_root, std::less<>{}, std::ptrdiff_t{1}, reversed);
+	assert_tree_keys<tree_key>(std::span(nodes), root, [&](std::ptrdiff_t k) { return in_a(k) and not in_b(k); });
+	assert(red_black_tree::size<tree_type>(base, other_root) == 55);
+
+	std::tie(root, other_root) = red_black_tree::set_union<tree_type>(base, other_root, root, std::less<>{});
+	assert_valid_tree(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{100});
+	assert_empty_tree<decltype(base)>(other_root);
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_tree_range_erase() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	root = red_black_tree::build_sorted<tree_type>(base, base, std::span(nodes).end());
+
+	auto first = red_black_tree::find<tree_type>(base, root, tree_key{20}, std::less<>{});
+	auto last = red_black_tree::find<tree_type>(base, root, tree_key{50}, std::less<>{});
+	auto [kept, erased] = red_black_tree::erase<tree_type>(root, first, last);
+	assert_tree_keys<tree_key>(std::span(nodes), kept, [](std::ptrdiff_t k) { return k < 20 or (k >= 50 and k < 100); });
+	assert_tree_keys<tree_key>(std::span(nodes), erased, [](std::ptrdiff_t k) { return k >= 20 and k < 50; });
+
+	std::tie(kept, root) = red_black_tree::erase<tree_type>(kept, red_black_tree::begin<tree_type>(base, kept), red_black_tree::end<tree_type>(base));
+	assert_empty_tree<decltype(base)>(kept);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{70});
+	std::tie(root, erased) = red_black_tree::erase<tree_type>(root, red_black_tree::find<tree_type>(base, root, tree_key{99}, std::less<>{}), red_black_tree::end<tree_type>(base));
+	assert_tree_keys<tree_key>(std::span(nodes), root, [](std::ptrdiff_t k) { return k < 20 or (k >= 50 and k < 99); });
+	assert_tree_size(std::span(nodes), erased, std::ptrdiff_t{1});
+
+	std::tie(root, erased) = red_black_tree::erase_if<tree_type>(base, root, [](const auto& node) { return std::size_t(tree_key(get<tree_key>(node))) % 3 == 0; });
+	assert_tree_keys<tree_key>(std::span(nodes), root, [](std::ptrdiff_t k) { return (k < 20 or (k >= 50 and k < 99)) and k % 3; });
+	assert_tree_keys<tree_key>(std::span(nodes), erased, [](std::ptrdiff_t k) { return (k < 20 or (k >= 50 and k < 99)) and not (k % 3); });
+	std::tie(root, erased) = red_black_tree::erase_if<tree_type>(base, root, [](const auto&) { return true; });
+	assert_empty_tree<decltype(base)>(root);
+	assert_tree_size(std::span(nodes), erased, std::ptrdiff_t{46});
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_tree_forked_validate() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto forks = std::size_t{};
+	auto reversed = [&](auto&& f, auto&& g) { ++forks; g(); f(); };
+	auto valid = [&] { return red_black_tree::validate<tree_type>(std::span(nodes), root, std::less<>{}, std::ptrdiff_t{3}, reversed); };
+
+	assert(valid());
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		root = red_black_tree::insert<tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	assert(valid());
+	assert(forks == 1 + 2 + 4);
+
+	get<tree_key>(nodes[50]) = tree_key{52};
+	assert(not valid());
+	get<tree_key>(nodes[50]) = tree_key{50};
+	auto i = std::size_t{};
+	while (std::size_t(std::get<tree_type::left_type>(nodes[i].ts)) or std::size_t(std::get<tree_type::right_type>(nodes[i].ts)))
+		++i;
+	auto& leaf = nodes[i].ts;
+	auto color = std::get<tree_type::color_type>(leaf);
+	std::get<tree_type::color_type>(leaf) = tree_type::color_type(not bool(color));
+	assert(not valid());
+	std::get<tree_type::color_type>(leaf) = color;
+	std::get<tree_type::right_type>(leaf) = tree_type::right_type(root);
+	assert(not valid());
+	std::get<tree_type::right_type>(leaf) = tree_type::right_type{};
+	assert(valid());
+	assert(red_black_tree::validate<tree_type>(base, std::span(nodes).end(), root, std::less<>{}, std::ptrdiff_t{}, reversed));
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_tree_hinted_insert() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto comparisons = std::size_t{};
+	auto less = [&](auto a, auto b) { ++comparisons; return a < b; };
+
+	for (auto hint = red_black_tree::end<tree_type>(base); const auto& node : std::views::iota(base, base + 40)) {
+		std::tie(hint, root) = red_black_tree::insert<tree_type>(base, root, hint, node, less);
+		assert(&*hint == &*node);
+	}
+	assert(comparisons <= 2 * 40);
+	assert_valid_tree(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{40});
+
+	for (auto hint = red_black_tree::end<tree_type>(base); const auto& node : std::views::iota(base + 40, base + 60))
+		std::tie(std::ignore, root) = red_black_tree::insert<tree_type>(base, root, hint, node, less);
+	assert_valid_tree(std::span(nodes), root);
+
+	comparisons = 0;
+	for (auto hint = red_black_tree::end<tree_type>(base); const auto& node : std::views::iota(base + 60, base + 100) | std::views::reverse)
+		std::tie(hint, root) = red_black_tree::insert<tree_type>(base, root, hint, node, less);
+	assert(comparisons <= 3 * 40);
+	assert_valid_tree(std::span(nodes), root);
+
+	root = init_tree_nodes<tree_key>(std::span(nodes));
+	for (const auto& node : std::views::iota(base, std::span(nodes).end()) | std::views::filter([&](auto it) { return std::distance(base, it) % 2 == 0; }))
+		root = red_black_tree::insert<tree_type>(base, root, node, std::less<>{});
+	for (const auto& node : std::views::iota(base, std::span(nodes).end()) | std::views::filter([&](auto it) { return std::distance(base, it) % 2 == 1; })) {
+		auto [it, new_root] = red_black_tree::insert<tree_type>(base, root, red_black_tree::find<tree_type>(base, root, tree_key(std::distance(base, node) - 1), std::less<>{}), node, std::less<>{});
+		root = new_root;
+		assert(it == red_black_tree::make_iterator<tree_type>(base, node));
+		root = red_black_tree::erase<tree_type>(root, it);
+		std::tie(it, root) = red_black_tree::insert<tree_type>(base, root, red_black_tree::begin<tree_type>(base, root), node, std::less<>{});
+		assert_valid_tree(std::span(nodes), root);
+	}
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{100});
+	assert_tree_nodes_increase_addr(std::span(nodes), root);
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_tree_three_way() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto comparisons = std::size_t{};
+	auto compare = [&](auto a, auto b) { ++comparisons; return a <=> b; };
+	auto end = red_black_tree::end<tree_type>(base);
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		get<tree_key>(nodes[std::size_t(i)]) = tree_key(i / 2);
+	for (const auto& node : std::views::iota(base, base + 100))
+		root = red_black_tree::insert<tree_type>(base, root, node, compare);
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), root, std::compare_three_way{}));
+
+	comparisons = 0;
+	auto it = red_black_tree::find<tree_type>(base, root, tree_key{21}, compare);
+	assert(it not_eq end and tree_key(get<tree_key>(*it)) == tree_key{21});
+	assert(comparisons <= 2 * 7);
+	assert(red_black_tree::find<tree_type>(base, root, tree_key{50}, compare) == end);
+
+	for (auto k = std::size_t{}; k <= 50; ++k) {
+		comparisons = 0;
+		auto [first, last] = red_black_tree::equal_range<tree_type>(base, root, tree_key(k), compare);
+		assert(comparisons <= 2 * 2 * 7);
+		assert(first == red_black_tree::lower_bound<tree_type>(base, root, tree_key(k), std::less<>{}));
+		assert(last == red_black_tree::upper_bound<tree_type>(base, root, tree_key(k), std::compare_three_way{}));
+		assert(std::distance(first, last) == (k < 50 ? 2 : 0));
+		auto [less_first, less_last] = red_black_tree::equal_range<tree_type>(base, root, tree_key(k), std::less<>{});
+		assert(less_first == first and less_last == last);
+	}
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_tree_batch_lookup() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	using tree_key = typename tree_type::key_type;
+	using iterator = red_black_tree::forward_iter<tree_type, decltype(std::span(nodes).begin())>;
+	auto base = std::span(nodes).begin();
+	std::array<tree_key, 121> values{};
+	std::array<iterator, 121> results{};
+	for (auto i = std::size_t{}; i < values.size(); ++i)
+		values[i] = tree_key(i);
+
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	assert(red_black_tree::find_batch<tree_type>(base, root, values.begin(), values.end(), results.begin(), std::less<>{}) == results.end());
+	assert(std::ranges::all_of(results, [&](auto it) { return it == red_black_tree::end<tree_type>(base); }));
+
+	root = red_black_tree::build_sorted<tree_type>(base, base, std::span(nodes).end());
+	root = assert_remove_odd_tree_nodes(std::span(nodes), root);
+
+	(void)red_black_tree::lower_bound_batch<tree_type>(base, root, values.begin(), values.end(), results.begin(), std::less<>{});
+	for (auto i = std::size_t{}; i < values.size(); ++i)
+		assert(results[i] == red_black_tree::lower_bound<tree_type>(base, root, values[i], std::less<>{}));
+	(void)red_black_tree::upper_bound_batch<tree_type>(base, root, values.begin(), values.end(), results.begin(), std::less<>{});
+	for (auto i = std::size_t{}; i < values.size(); ++i)
+		assert(results[i] == red_black_tree::upper_bound<tree_type>(base, root, values[i], std::less<>{}));
+	(void)red_black_tree::find_batch<tree_type>(base, root, values.begin(), values.end(), results.begin(), std::less<>{});
+	for (auto i = std::size_t{}; i < values.size(); ++i)
+		assert(results[i] == red_black_tree::find<tree_type>(base, root, values[i], std::less<>{}));
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_tree_relayout() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	std::array<std::ptrdiff_t, 101> moved_to{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+
+	assert(red_black_tree::relayout<tree_type>(base, base, base, root) == 0);
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		root = red_black_tree::insert<tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	root = red_black_tree::relayout<tree_type>(base, base, std::span(nodes).end(), root, [&](std::ptrdiff_t from, std::ptrdiff_t to) { moved_to[std::size_t(from)] = to; });
+	assert(root == 1);
+	assert_valid_tree(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{100});
+	for (auto i = std::size_t{1}; i <= 100; ++i)
+		assert(std::size_t(tree_key(get<tree_key>(nodes[std::size_t(moved_to[i] - 1)]))) == i - 1);
+
+	auto depth = [&](std::ptrdiff_t x) { auto d = 0; for (; x not_eq root; ++d) x = std::ptrdiff_t(tree_type::parent_type(get<tree_type::parent_type>(nodes[std::size_t(x - 1)]))); return d; };
+	for (auto i = std::ptrdiff_t{2}; i <= 100; ++i)
+		assert(depth(i - 1) <= depth(i));
+	std::for_each(red_black_tree::begin<tree_type>(base, root), red_black_tree::end<tree_type>(base), [i = std::size_t{}](const auto& node) mutable
+	{
+		assert(std::size_t(tree_key(get<tree_key>(node))) == i++);
+	});
+
+	root = assert_remove_odd_tree_nodes(std::span(nodes), root);
+	for (auto i = std::ptrdiff_t{1}; i < 100; i += 2)
+		root = red_black_tree::insert<tree_type>(base, root, base + i, std::less<>{});
+	root = red_black_tree::relayout<tree_type>(base, base, std::span(nodes).end(), root);
+	assert_valid_tree(std::span(nodes), root);
+	assert_tree_size(std::span(nodes), root, std::ptrdiff_t{100});
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_static_search_tree() noexcept
+{
+	std::array<example_node, 100> nodes{};
+	std::array<std::int32_t, 112> keys{};
+	std::array<std::ptrdiff_t, 112> indices{};
+	using tree_key = typename tree_type::key_type;
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+
+	auto slots = static_search_tree::build<tree_type>(base, root, keys.begin(), indices.begin());
+	assert(slots == 0);
+	assert(static_search_tree::lower_bound<tree_type>(base, keys.begin(), indices.begin(), slots, 0) == red_black_tree::end<tree_type>(base));
+
+	root = red_black_tree::build_sorted<tree_type>(base, base, std::span(nodes).end());
+	root = assert_remove_odd_tree_nodes(std::span(nodes), root);
+	slots = static_search_tree::build<tree_type>(base, root, keys.begin(), indices.begin(), [](tree_key key) { return std::int32_t(key) + 1; });
+	assert(slots == static_search_tree::capacity(50));
+
+	assert(static_search_tree::lower_bound<tree_type>(base, keys.begin(), indices.begin(), slots, std::numeric_limits<std::int32_t>::min()) == red_black_tree::begin<tree_type>(base, root));
+	for (auto v = std::int32_t{}; v < 102; ++v) {
+		assert(static_search_tree::lower_bound<tree_type>(base, keys.begin(), indices.begin(), slots, v + 1) == red_black_tree::lower_bound<tree_type>(base, root, tree_key(v), std::less<>{}));
+		assert(static_search_tree::find<tree_type>(base, keys.begin(), indices.begin(), slots, v + 1) == red_black_tree::find<tree_type>(base, root, tree_key(v), std::less<>{}));
+	}
+	assert(static_search_tree::find<tree_type>(base, keys.begin(), indices.begin(), slots, std::numeric_limits<std::int32_t>::max()) == red_black_tree::end<tree_type>(base));
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_prefixed_tree() noexcept
+{
+	using tree_key = typename prefixed_tree_type::key_type;
+	using tree_prefix = typename prefixed_tree_type::prefix_type;
+	std::array<tuple_node<tree_type::left_type, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_key, tree_prefix>, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto comparisons = std::size_t{};
+	auto less = [&](auto a, auto b) { ++comparisons; return a < b; };
+	auto end = red_black_tree::end<prefixed_tree_type>(base);
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		root = red_black_tree::insert<prefixed_tree_type>(base, root, base + i * 37 % 100, less);
+	assert(red_black_tree::validate<prefixed_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(comparisons < 100 * 5);
+
+	comparisons = 0;
+	assert(&*red_black_tree::find<prefixed_tree_type>(base, root, tree_key{42}, less) == &nodes[42]);
+	assert(&*red_black_tree::lower_bound<prefixed_tree_type>(base, root, tree_key{42}, less) == &nodes[42]);
+	assert(&*red_black_tree::upper_bound<prefixed_tree_type>(base, root, tree_key{42}, less) == &nodes[43]);
+	assert(comparisons <= 3 * 5);
+	assert(red_black_tree::find<prefixed_tree_type>(base, root, tree_key{100}, less) == end);
+	auto [first, last] = red_black_tree::equal_range<prefixed_tree_type>(base, root, tree_key{7}, std::compare_three_way{});
+	assert(&*first == &nodes[7] and &*last == &nodes[8]);
+
+	get<tree_prefix>(nodes[50]) = tree_prefix{};
+	assert(not red_black_tree::validate<prefixed_tree_type>(std::span(nodes), root, std::less<>{}));
+	get<tree_prefix>(nodes[50]) = prefixed_tree_type::prefix(tree_key{50});
+
+	for (auto [a, b] : { std::pair{ 20, 40 }, std::pair{ 0, 99 } }) {
+		get<tree_key>(nodes[std::size_t(a)]) = tree_key(b);
+		get<tree_key>(nodes[std::size_t(b)]) = tree_key(a);
+		root = red_black_tree::node_swap<prefixed_tree_type>(root, red_black_tree::make_iterator<prefixed_tree_type>(base, base + a), red_black_tree::make_iterator<prefixed_tree_type>(base, base + b));
+		assert(red_black_tree::validate<prefixed_tree_type>(std::span(nodes), root, std::less<>{}));
+		assert(&*red_black_tree::find<prefixed_tree_type>(base, root, tree_key(a), less) == &nodes[std::size_t(b)]);
+	}
+
+	root = red_black_tree::erase<prefixed_tree_type>(root, red_black_tree::find<prefixed_tree_type>(base, root, tree_key{60}, less));
+	auto [kept, erased] = red_black_tree::erase<prefixed_tree_type>(root, red_black_tree::find<prefixed_tree_type>(base, root, tree_key{61}, less), end);
+	assert(red_black_tree::validate<prefixed_tree_type>(std::span(nodes), kept, std::less<>{}));
+	root = red_black_tree::join<prefixed_tree_type>(base, kept, base + 60, erased);
+	assert(red_black_tree::validate<prefixed_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(red_black_tree::size<prefixed_tree_type>(base, root) == 100);
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_digested_tree() noexcept
+{
+	using tree_key = typename digested_tree_type::key_type;
+	using tree_digest = typename digested_tree_type::digest_type;
+	using digested_node = tuple_node<tree_type::left_type, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_key, tree_digest>;
+	std::array<digested_node, 100> nodes{};
+	std::array<digested_node, 100> other_nodes{};
+	auto base = std::span(nodes).begin();
+	auto other_base = std::span(other_nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto other_root = init_tree_nodes<tree_key>(std::span(other_nodes));
+	auto comparisons = std::size_t{};
+	auto equiv = [&](auto a, auto b) { ++comparisons; return a == b; };
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i) {
+		root = red_black_tree::insert<digested_tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+		other_root = red_black_tree::insert<digested_tree_type>(other_base, other_root, other_base + i, std::less<>{});
+	}
+	assert(red_black_tree::validate<digested_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(red_black_tree::validate<digested_tree_type>(std::span(other_nodes), other_root, std::less<>{}, std::ptrdiff_t{2}, [](auto&& f, auto&& g) { f(); g(); }));
+	assert(red_black_tree::digest<digested_tree_type>(base, root) == red_black_tree::digest<digested_tree_type>(other_base, other_root));
+	assert(red_black_tree::equal<digested_tree_type>(base, root, other_base, other_root, equiv));
+
+	for (auto k : { 10, 50 })
+		root = red_black_tree::erase<digested_tree_type>(root, red_black_tree::find<digested_tree_type>(base, root, tree_key(k), std::less<>{}));
+	other_root = red_black_tree::erase<digested_tree_type>(other_root, red_black_tree::find<digested_tree_type>(other_base, other_root, tree_key{30}, std::less<>{}));
+	assert(red_black_tree::validate<digested_tree_type>(std::span(nodes), root, std::less<>{}));
+	comparisons = 0;
+	assert(not red_black_tree::equal<digested_tree_type>(base, root, other_base, other_root, equiv));
+	assert(comparisons == 0);
+
+	std::array<red_black_tree::forward_iter<digested_tree_type, decltype(base)>, 4> only{};
+	std::array<red_black_tree::forward_iter<digested_tree_type, decltype(base)>, 4> other_only{};
+	auto [out, other_out] = red_black_tree::diff<digested_tree_type>(base, root, other_base, other_root, std::less<>{}, only.begin(), other_only.begin());
+	assert(out == only.begin() + 1 and &*only[0] == &nodes[30]);
+	assert(other_out == other_only.begin() + 2 and &*other_only[0] == &other_nodes[10] and &*other_only[1] == &other_nodes[50]);
+
+	get<tree_key>(nodes[11]) = tree_key{10};
+	root = red_black_tree::node_relink<digested_tree_type>(root, base + 10, red_black_tree::make_iterator<digested_tree_type>(base, base + 11));
+	assert(red_black_tree::validate<digested_tree_type>(std::span(nodes), root, std::less<>{}));
+	get<tree_digest>(nodes[20]) = tree_digest{};
+	assert(not red_black_tree::validate<digested_tree_type>(std::span(nodes), root, std::less<>{}));
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_aggregated_tree() noexcept
+{
+	using tree_key = typename aggregated_tree_type::key_type;
+	using tree_aggregate = typename aggregated_tree_type::aggregate_type;
+	using aggregated_node = tuple_node<tree_type::left_type, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_key, tree_aggregate>;
+	std::array<aggregated_node, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto expect = [&](std::size_t lo, std::size_t hi, auto erased) {
+		auto first = std::size_t(-1);
+		auto sum = std::size_t{};
+		for (auto k = lo; k < hi and k < 100; ++k)
+			if (not erased(k)) {
+				first = first == std::size_t(-1) ? k : first;
+				sum += k;
+			}
+		return tree_aggregate{ first, sum };
+	};
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		root = red_black_tree::insert<aggregated_tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	assert(red_black_tree::validate<aggregated_tree_type>(std::span(nodes), root, std::less<>{}));
+	for (auto lo = std::size_t{}; lo < 101; lo += 7)
+		for (auto hi = std::size_t{}; hi < 101; hi += 3)
+			assert(red_black_tree::aggregate_range<aggregated_tree_type>(base, root, tree_key(lo), tree_key(hi), std::less<>{}) == expect(lo, hi, [](std::size_t) { return false; }));
+
+	for (auto k : { 0, 13, 14, 60, 99 })
+		root = red_black_tree::erase<aggregated_tree_type>(root, red_black_tree::find<aggregated_tree_type>(base, root, tree_key(k), std::less<>{}));
+	auto [kept, erased] = red_black_tree::erase<aggregated_tree_type>(root, red_black_tree::find<aggregated_tree_type>(base, root, tree_key{30}, std::less<>{}), red_black_tree::find<aggregated_tree_type>(base, root, tree_key{40}, std::less<>{}));
+	root = kept;
+	auto gone = [](std::size_t k) { return k == 0 or k == 13 or k == 14 or k == 60 or k == 99 or (k >= 30 and k < 40); };
+	assert(red_black_tree::validate<aggregated_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(red_black_tree::validate<aggregated_tree_type>(std::span(nodes), erased, std::less<>{}));
+	for (auto lo = std::size_t{}; lo < 101; lo += 5)
+		for (auto hi = lo; hi < 101; hi += 4)
+			assert(red_black_tree::aggregate_range<aggregated_tree_type>(base, root, tree_key(lo), tree_key(hi), std::compare_three_way{}) == expect(lo, hi, gone));
+
+	get<tree_key>(nodes[50]) = tree_key{51};
+	assert(not red_black_tree::validate<aggregated_tree_type>(std::span(nodes), root, std::less<>{}));
+	get<tree_key>(nodes[51]) = tree_key{52};
+	get<tree_key>(nodes[52]) = tree_key{53};
+	for (auto i : { 50, 51, 52 })
+		red_black_tree::update_aggregate(red_black_tree::make_iterator<aggregated_tree_type>(base, base + i));
+	assert(red_black_tree::validate<aggregated_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(red_black_tree::aggregate_range<aggregated_tree_type>(base, root, tree_key{50}, tree_key{54}, std::less<>{}) == (tree_aggregate{ 51, 51 + 52 + 53 + 53 }));
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_interval_tree() noexcept
+{
+	using intervals = interval_tree::tree_type<interval_type>;
+	using tree_key = typename interval_type::key_type;
+	using tree_end = typename interval_type::end_type;
+	using interval_node = tuple_node<tree_type::left_type, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_key, tree_end, interval_type::max_end_type>;
+	std::array<interval_node, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto less = [](auto a, auto b) { return std::size_t(a) < std::size_t(b); };
+	auto end_of = [](std::size_t i) { return i + i * 7 % 13 + 1; };
+	auto in_tree = std::array<bool, 100>{};
+	for (auto i = std::size_t{}; i < 100; ++i)
+		get<tree_end>(nodes[i]) = tree_end(end_of(i));
+	for (auto i = std::size_t{}; i < 100; ++i) {
+		root = red_black_tree::insert<intervals>(base, root, base + std::ptrdiff_t(i * 37 % 100), less);
+		in_tree[i * 37 % 100] = true;
+	}
+	assert(red_black_tree::validate<intervals>(std::span(nodes), root, less));
+	assert(interval_tree::max_end<interval_type>(base, root) == tree_end(end_of(98)));
+
+	auto check = [&](std::size_t lo, std::size_t hi) {
+		auto found = std::array<bool, 100>{};
+		auto last = std::size_t{};
+		auto k = std::size_t{};
+		interval_tree::for_each_overlap<interval_type>(base, root, lo, hi, less, [&](auto it) {
+			auto i = std::size_t(tree_key(get<tree_key>(*it)));
+			assert(k == 0 or last <= i);
+			found[i] = true;
+			last = i;
+			++k;
+		});
+		auto expected = std::size_t{};
+		for (auto i = std::size_t{}; i < 100; ++i) {
+			auto overlaps = in_tree[i] and i < hi and lo < end_of(i);
+			assert(found[i] == overlaps);
+			expected += overlaps;
+		}
+		assert(k == expected);
+		auto any = interval_tree::find_any_overlap<interval_type>(base, root, lo, hi, less);
+		assert((any == red_black_tree::end<intervals>(base)) == (expected == 0));
+		if (any not_eq red_black_tree::end<intervals>(base))
+			assert(found[std::size_t(tree_key(get<tree_key>(*any)))]);
+
+		auto stabbed = std::size_t{};
+		interval_tree::stab<interval_type>(base, root, lo, less, [&](auto it) {
+			auto i = std::size_t(tree_key(get<tree_key>(*it)));
+			assert(i <= lo and lo < end_of(i));
+			++stabbed;
+		});
+		auto containing = std::size_t{};
+		for (auto i = std::size_t{}; i < 100; ++i)
+			containing += in_tree[i] and i <= lo and lo < end_of(i);
+		assert(stabbed == containing);
+	};
+	for (auto lo = std::size_t{}; lo < 120; lo += 7)
+		for (auto hi = lo; hi < 120; hi += 5)
+			check(lo, hi);
+
+	for (auto i : { 98, 96, 40, 41, 42, 3 }) {
+		root = red_black_tree::erase<intervals>(root, red_black_tree::make_iterator<intervals>(base, base + i));
+		in_tree[std::size_t(i)] = false;
+	}
+	assert(red_black_tree::validate<intervals>(std::span(nodes), root, less));
+	assert(interval_tree::max_end<interval_type>(base, root) == tree_end(end_of(99)));
+	for (auto lo = std::size_t{}; lo < 120; lo += 3)
+		check(lo, lo + 4);
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_flatten() noexcept
+{
+	using tree_key = typename tree_type::key_type;
+	std::array<example_node, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	std::array<std::ptrdiff_t, 100> links{};
+	std::array<std::size_t, 100> keys{};
+	assert(red_black_tree::flatten<tree_type>(base, root, links.begin()) == links.begin());
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		root = red_black_tree::insert<tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	root = red_black_tree::erase<tree_type>(root, red_black_tree::find<tree_type>(base, root, tree_key{50}, std::less<>{}));
+
+	assert(red_black_tree::flatten<tree_type>(base, root, links.begin()) == links.begin() + 99);
+	auto [out, keys_out] = red_black_tree::flatten<tree_type>(base, root, links.begin(), keys.begin(), [](tree_key key) { return std::size_t(key) * 2; });
+	assert(out == links.begin() + 99 and keys_out == keys.begin() + 99);
+	auto it = red_black_tree::begin<tree_type>(base, root);
+	for (auto i = std::size_t{}; i < 99; ++i, ++it) {
+		assert(links[i] == it.root);
+		assert(keys[i] == (i < 50 ? i : i + 1) * 2);
+	}
+
+	std::array<example_list, 100> list{};
+	auto head = std::ptrdiff_t{};
+	auto single_head = std::ptrdiff_t{};
+	for (auto node = list.begin(); node not_eq list.begin() + 60; ++node)
+		single_head = head = double_list::push_front<list_type>(list.begin(), head, node);
+	std::array<std::ptrdiff_t, 100> list_links{};
+	auto [list_out, values_out] = double_list::flatten<list_type>(list.begin(), head, links.begin(), list_links.begin(), [&](const example_list& node) { return std::ptrdiff_t(&node - list.data()) + 1; });
+	assert(list_out == links.begin() + 60 and values_out == list_links.begin() + 60);
+	assert(single_list::flatten<list_type>(list.begin(), single_head, keys.begin()) == keys.begin() + 60);
+	for (auto i = std::size_t{}; i < 60; ++i)
+		assert(links[i] == std::ptrdiff_t(60 - i) and list_links[i] == links[i] and keys[i] == std::size_t(links[i]));
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_persistent_tree() noexcept
+{
+	using tree_key = typename persistent_tree_type::key_type;
+	using tree_refcount = typename persistent_tree_type::refcount_type;
+	std::array<tuple_node<persistent_tree_type::left_type, persistent_tree_type::right_type, persistent_tree_type::color_type, tree_refcount, tree_key>, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	std::array<std::ptrdiff_t, 100> free_slots{};
+	auto free_count = std::ptrdiff_t{};
+	for (auto i = std::ptrdiff_t{100}; i > 0; --i)
+		free_slots[free_count++] = i - 1;
+	auto alloc = [&] { return base + free_slots[--free_count]; };
+	auto dealloc = [&](auto it) { free_slots[free_count++] = std::distance(base, it); };
+	auto keys = [&](std::ptrdiff_t root) {
+		auto out = std::array<std::size_t, 100>{};
+		auto n = std::size_t{};
+		for (auto it = parentless_red_black_tree::begin<persistent_tree_type>(base, root); it.link(); ++it)
+			out[n++] = std::size_t(tree_key(get<tree_key>(*it)));
+		return std::pair{ out, n };
+	};
+	auto insert = [&](std::ptrdiff_t root, std::size_t key) {
+		auto it = alloc();
+		get<tree_key>(*it) = tree_key(key);
+		return persistent_red_black_tree::insert<persistent_tree_type>(base, root, it, std::less<>{}, alloc);
+	};
+
+	auto root = std::ptrdiff_t{};
+	for (auto i = std::size_t{}; i < 20; ++i)
+		root = insert(root, i * 7 % 20);
+	assert(persistent_red_black_tree::validate<persistent_tree_type>(std::span(nodes), root, std::less<>{}));
+	// An unshared version changes in place.
+	assert(free_count == 80);
+
+	auto snapshot = persistent_red_black_tree::retain<persistent_tree_type>(base, root);
+	auto before = keys(snapshot);
+	root = insert(root, 20);
+	root = persistent_red_black_tree::erase<persistent_tree_type>(base, root, tree_key{3}, std::less<>{}, alloc, dealloc);
+	root = persistent_red_black_tree::erase<persistent_tree_type>(base, root, tree_key{42}, std::less<>{}, alloc, dealloc);
+	assert(persistent_red_black_tree::validate<persistent_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(persistent_red_black_tree::validate<persistent_tree_type>(std::span(nodes), snapshot, std::less<>{}));
+	assert(keys(snapshot) == before);
+	auto [after, n] = keys(root);
+	assert(n == 20 and after[0] == 0 and after[3] == 4 and after[19] == 20);
+	// Only the paths changed were copied.
+	assert(free_count > 60);
+
+	for (auto i = std::size_t{}; i < 20; i += 2)
+		root = persistent_red_black_tree::erase<persistent_tree_type>(base, root, tree_key(i), std::less<>{}, alloc, dealloc);
+	assert(persistent_red_black_tree::validate<persistent_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(keys(snapshot) == before);
+	assert(keys(root).second == 10);
+
+	persistent_red_black_tree::release<persistent_tree_type>(base, snapshot, dealloc);
+	assert(persistent_red_black_tree::validate<persistent_tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(free_count == 90);
+	persistent_red_black_tree::release<persistent_tree_type>(base, root, dealloc);
+	assert(free_count == 100);
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_wavl_tree() noexcept
+{
+	using tree_key = typename wavl_tree_type::key_type;
+	using tree_parity = typename wavl_tree_type::parity_type;
+	std::array<tuple_node<wavl_tree_type::left_type, wavl_tree_type::right_type, wavl_tree_type::parent_type, tree_parity, tree_key>, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto valid = [&] { return wavl_tree::validate<wavl_tree_type>(std::span(nodes), root, std::less<>{}) and wavl_tree::validate<wavl_tree_type>(base, std::span(nodes).end(), root, std::less<>{}); };
+	auto end = wavl_tree::end<wavl_tree_type>(base);
+	auto height = [&] {
+		auto h = std::ptrdiff_t{};
+		for (auto i = std::ptrdiff_t{1}; i <= 100; ++i) {
+			auto depth = std::ptrdiff_t{};
+			for (auto x = i; x; x = std::ptrdiff_t(wavl_tree_type::parent_type(get<wavl_tree_type::parent_type>(nodes[x - 1]))))
+				++depth;
+			h = std::max(h, depth);
+		}
+		return h;
+	};
+
+	// Insertions alone build an AVL tree, even in order.
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i)
+		root = wavl_tree::insert<wavl_tree_type>(base, root, base + i, std::less<>{});
+	assert(valid());
+	assert(wavl_tree::size<wavl_tree_type>(base, root) == 100);
+	assert(height() == 7);
+
+	auto k = std::ptrdiff_t{};
+	for (auto it = wavl_tree::begin<wavl_tree_type>(base, root); it not_eq end; ++it)
+		assert(&*it == &nodes[k++]);
+	for (auto it = wavl_tree::find<wavl_tree_type>(base, root, tree_key(99), std::less<>{}); k < 100; --it)
+		assert(&*it == &nodes[99 - k++]);
+
+	assert(&*wavl_tree::find<wavl_tree_type>(base, root, tree_key(42), std::less<>{}) == &nodes[42]);
+	assert(wavl_tree::find<wavl_tree_type>(base, root, tree_key(100), std::less<>{}) == end);
+	assert(wavl_tree::lower_bound<wavl_tree_type>(base, root, tree_key(100), std::less<>{}) == end);
+	assert(&*wavl_tree::upper_bound<wavl_tree_type>(base, root, tree_key(41), std::less<>{}) == &nodes[42]);
+
+	auto leaf = std::ptrdiff_t(&*wavl_tree::begin<wavl_tree_type>(base, root) - nodes.data());
+	get<tree_parity>(nodes[leaf]) = tree_parity(true);
+	assert(not valid());
+	get<tree_parity>(nodes[leaf]) = tree_parity(false);
+	assert(valid());
+
+	for (auto i = std::size_t{}; i < 100; i += 3)
+		root = wavl_tree::erase<wavl_tree_type>(root, wavl_tree::find<wavl_tree_type>(base, root, tree_key(i), std::less<>{}));
+	assert(valid());
+	assert(wavl_tree::size<wavl_tree_type>(base, root) == 66);
+	assert(wavl_tree::find<wavl_tree_type>(base, root, tree_key(42), std::less<>{}) == end);
+
+	auto it = wavl_tree::make_iterator<wavl_tree_type>(base, base + 10);
+	get<tree_key>(nodes[9]) = tree_key(10);
+	root = wavl_tree::node_relink<wavl_tree_type>(root, base + 9, it);
+	assert(valid());
+	assert(&*wavl_tree::find<wavl_tree_type>(base, root, tree_key(10), std::less<>{}) == &nodes[9]);
+	root = wavl_tree::erase<wavl_tree_type>(root, wavl_tree::make_iterator<wavl_tree_type>(base, base + 9));
+
+	for (auto i = std::size_t{}; i < 100; ++i)
+		if (auto found = wavl_tree::find<wavl_tree_type>(base, root, tree_key(i), std::less<>{}); found not_eq end) {
+			root = wavl_tree::erase<wavl_tree_type>(root, found);
+			assert(valid());
+		}
+	assert(wavl_tree::empty<decltype(base)>(root));
+	return true;
+}
+
+// Not constexpr, because of the atomics of the header, so this one runs at runtime.
+[[nodiscard]] auto test_shared_tree() noexcept
+{
+	using tree_key = typename tree_type::key_type;
+	using tree_left = typename tree_type::left_type;
+	std::array<tuple_node<tree_left, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_key>, 100> nodes{};
+	auto first = std::span(nodes).begin();
+	auto last = std::span(nodes).end();
+	shared_tree::header<std::ptrdiff_t> h{};
+	h.root = init_tree_nodes<tree_key>(std::span(nodes));
+
+	for (auto i = std::ptrdiff_t{}; i < 100; i += 2)
+		shared_tree::insert<tree_type>(h, first, first + i * 37 % 100, std::less<>{});
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), h.root.load(), std::less<>{}));
+	assert(h.size.load() == 50);
+	assert(h.sequence.load() == 100);
+
+	auto keys = [&](std::ptrdiff_t root, std::ptrdiff_t size) {
+		auto out = std::array<std::ptrdiff_t, 100>{};
+		auto n = std::ptrdiff_t{};
+		auto [x, ok] = shared_tree::begin<tree_type>(first, last, root);
+		for (; ok and x and n < size; std::tie(x, ok) = shared_tree::next<tree_type>(first, last, x))
+			out[n++] = std::ptrdiff_t(tree_key(get<tree_key>(nodes[x - 1])));
+		return std::pair{ out, ok and n == size };
+	};
+	auto [all, complete] = shared_tree::read(h, keys);
+	assert(complete);
+	for (auto i = std::ptrdiff_t{}; i < 50; ++i)
+		assert(all[i] == i * 2);
+
+	auto found = shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::find<tree_type>(first, last, root, tree_key{42}, std::less<>{}); });
+	assert(found == std::pair(std::ptrdiff_t{43}, true));
+	found = shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::find<tree_type>(first, last, root, tree_key{43}, std::less<>{}); });
+	assert(found == std::pair(std::ptrdiff_t{}, true));
+	found = shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::lower_bound<tree_type>(first, last, root, tree_key{43}, std::less<>{}); });
+	assert(found == std::pair(std::ptrdiff_t{45}, true));
+	found = shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::upper_bound<tree_type>(first, last, root, tree_key{98}, std::less<>{}); });
+	assert(found == std::pair(std::ptrdiff_t{}, true));
+
+	// A read overlapping a change doesn't hold, even though it finished.
+	shared_tree::begin_write(h);
+	assert(not shared_tree::try_read(h, keys).second);
+	shared_tree::end_write(h);
+	assert(shared_tree::try_read(h, keys).second);
+
+	// Links out of the range fail the read instead of being followed, and so do cycles.
+	auto leaf = shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::lower_bound<tree_type>(first, last, root, tree_key{}, std::less<>{}); }).first;
+	get<tree_left>(nodes[leaf - 1]) = tree_left(101);
+	assert(not shared_tree::read(h, keys).second);
+	assert(not shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::lower_bound<tree_type>(first, last, root, tree_key{}, std::less<>{}); }).second);
+	get<tree_left>(nodes[leaf - 1]) = tree_left(h.root.load());
+	assert(not shared_tree::read(h, [&](std::ptrdiff_t root, std::ptrdiff_t) { return shared_tree::lower_bound<tree_type>(first, last, root, tree_key{}, std::less<>{}); }).second);
+	get<tree_left>(nodes[leaf - 1]) = tree_left{};
+
+	for (auto i = std::size_t{}; i < 100; i += 4)
+		shared_tree::erase<tree_type>(h, red_black_tree::find<tree_type>(first, h.root.load(), tree_key(i), std::less<>{}));
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), h.root.load(), std::less<>{}));
+	assert(h.size.load() == 25);
+	std::tie(all, complete) = shared_tree::read(h, keys);
+	assert(complete);
+	for (auto i = std::ptrdiff_t{}; i < 25; ++i)
+		assert(all[i] == i * 4 + 2);
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_undo_log() noexcept
+{
+	using tree_key = typename tree_type::key_type;
+	auto same = [](const auto& a, const auto& b) { return a.ts == b.ts; };
+	std::array<example_node, 40> nodes{};
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	for (auto it = nodes.begin(); it not_eq nodes.begin() + 30; ++it)
+		root = red_black_tree::insert<tree_type>(nodes.begin(), root, it, std::less<>{});
+	std::array<example_node, 40> before{};
+	before = nodes;
+
+	std::array<undo_log::record<example_node>, 96> records{};
+	auto size = std::ptrdiff_t{};
+	auto j = undo_log::journal<decltype(nodes.begin()), decltype(records.begin())>{ nodes.begin(), nodes.end(), records.begin(), 96, &size, {}, false };
+	auto base = undo_log::begin(j);
+	auto tx_root = root;
+	for (auto i = 30; i < 35; ++i)
+		tx_root = red_black_tree::insert<tree_type>(base, tx_root, base + i, std::less<>{});
+	tx_root = red_black_tree::erase<tree_type>(tx_root, red_black_tree::find<tree_type>(base, tx_root, tree_key{3}, std::less<>{}));
+	assert(red_black_tree::validate<tree_type>(base, base + 40, tx_root, std::less<>{}));
+	assert(size > 0 and size < 96);
+
+	// A crash leaves the log and whatever was stored, which recover undoes from the log alone.
+	std::array<example_node, 40> crashed{};
+	crashed = nodes;
+	auto crashed_size = size;
+	undo_log::recover(crashed.begin(), crashed.end(), records.begin(), crashed_size);
+	assert(crashed_size == 0 and std::ranges::equal(crashed, before, same));
+
+	assert(undo_log::rollback(j));
+	assert(size == 0 and std::ranges::equal(nodes, before, same));
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), root, std::less<>{}));
+
+	root = red_black_tree::erase<tree_type>(root, red_black_tree::find<tree_type>(base, root, tree_key{3}, std::less<>{}));
+	assert(undo_log::commit(j));
+	assert(size == 0 and not std::ranges::equal(nodes, before, same));
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(red_black_tree::find<tree_type>(nodes.begin(), root, tree_key{3}, std::less<>{}) == red_black_tree::end<tree_type>(nodes.begin()));
+
+	// Stores past a full log still happen, but can't be rolled back.
+	j.capacity = 2;
+	for (auto i = 30; i < 35; ++i)
+		root = red_black_tree::insert<tree_type>(base, root, base + i, std::less<>{});
+	assert(j.overflowed and size == 2);
+	assert(not undo_log::rollback(j));
+	assert(not undo_log::commit(j));
+	assert(size == 0 and not j.overflowed);
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), root, std::less<>{}));
+	assert(red_black_tree::size<tree_type>(nodes.begin(), root) == 34);
+
+	std::array<example_list, 40> list{};
+	auto tail = std::ptrdiff_t{};
+	for (auto it = list.begin(); it not_eq list.begin() + 20; ++it)
+		tail = double_list::push_back<list_type>(list.begin(), tail, it);
+	std::array<example_list, 40> old_list{};
+	old_list = list;
+	std::array<undo_log::record<example_list>, 8> list_records{};
+	auto list_journal = undo_log::journal<decltype(list.begin()), decltype(list_records.begin())>{ list.begin(), list.end(), list_records.begin(), 8, &size, {}, false };
+	auto list_base = undo_log::begin(list_journal);
+	auto list_tail = double_list::erase_after<list_type>(tail, double_list::begin<list_type>(list_base, std::ptrdiff_t{ 7 }));
+	list_tail = double_list::push_back<list_type>(list_base, list_tail, list_base + 30);
+	assert(list_tail == 31 and size == 4);
+	assert(undo_log::rollback(list_journal));
+	assert(std::ranges::equal(list, old_list, same));
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_portable_tree() noexcept
+{
+	using tree_key = typename portable_tree_type::key_type;
+	static_assert(intrusive::portable_layout<portable_node> and sizeof(portable_node) == 11);
+	static_assert(not intrusive::portable_layout<example_node>);
+
+	// Three nodes as any host writes them: links, the parent big endian, a color byte and little endian keys -1, 5 and 300.
+	constexpr auto image = std::array<unsigned char, 33>{
+		0, 0, 0, 0, 0, 2, 0, 0xff, 0xff, 0xff, 0xff,
+		1, 0, 3, 0, 0, 0, 1, 5, 0, 0, 0,
+		0, 0, 0, 0, 0, 2, 0, 0x2c, 0x01, 0, 0,
+	};
+	auto loaded = std::bit_cast<std::array<portable_node, 3>>(image);
+	assert(red_black_tree::validate<portable_tree_type>(std::span(loaded), 2, std::less<>{}));
+	assert(&*red_black_tree::find<portable_tree_type>(loaded.begin(), 2, tree_key(300), std::less<>{}) == &loaded[2]);
+	assert(red_black_tree::begin<portable_tree_type>(loaded.begin(), 2)->key == tree_key(-1));
+
+	std::array<portable_node, 100> nodes{};
+	auto root = std::ptrdiff_t{};
+	for (auto i = 0; i < 100; ++i) {
+		nodes[std::size_t(i)].key = tree_key(i * 37 % 100 - 50);
+		root = red_black_tree::insert<portable_tree_type>(nodes.begin(), root, nodes.begin() + i, std::less<>{});
+	}
+	assert(red_black_tree::validate<portable_tree_type>(std::span(nodes), root, std::less<>{}));
+	auto k = -50;
+	for (auto it = red_black_tree::begin<portable_tree_type>(nodes.begin(), root); it not_eq red_black_tree::end<portable_tree_type>(nodes.begin()); ++it)
+		assert(int(it->key) == k++);
+
+	auto bytes = std::bit_cast<std::array<unsigned char, sizeof(nodes)>>(nodes);
+	auto& first = nodes[std::size_t(std::ptrdiff_t(nodes[std::size_t(root - 1)].left) - 1)];
+	auto at = std::size_t(&first - nodes.data()) * sizeof(portable_node);
+	assert(bytes[at + 4] == 0 and bytes[at + 5] == root);
+	assert(bytes[at + 7] == std::uint8_t(int(first.key)) and bytes[at + 10] == (int(first.key) < 0 ? 0xff : 0));
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_packed_links() noexcept
+{
+	static_assert(sizeof(intrusive::link_for_t<255, struct a>) == 1 and sizeof(intrusive::link_for_t<256, struct a>) == 2);
+	static_assert(sizeof(intrusive::link_for_t<65536, struct a>) == 3 and sizeof(intrusive::link_for_t<(1 << 24) - 1, struct a>) == 3);
+	static_assert(sizeof(intrusive::link_for_t<1 << 24, struct a>) == 4 and sizeof(intrusive::link_for_t<100'000'000'000, struct a>) == 5);
+	static_assert(sizeof(intrusive::link_for_t<1ull << 40, struct a>) == 6 and sizeof(intrusive::link_for_t<~0ull, struct a>) == 8);
+	static_assert(std::same_as<intrusive::link_for_t<1'000'000, struct a, std::endian::big>, intrusive::be_u24_link<struct a>>);
+	static_assert(intrusive::portable_layout<intrusive::le_u40_link<struct a>> and alignof(intrusive::be_u48_link<struct a>) == 1);
+
+	auto l = intrusive::le_u24_link<struct a>(0xabcdef);
+	auto b = intrusive::be_u24_link<struct a>(0xabcdef);
+	assert(l.bytes[0] == 0xef and l.bytes[2] == 0xab and b.bytes[0] == 0xab and b.bytes[2] == 0xef);
+	assert(std::uint32_t(l) == 0xabcdef and std::uint32_t(b) == 0xabcdef);
+	assert(std::uint64_t(intrusive::be_u40_link<struct a>(0xff'1234567890)) == 0x1234567890);
+	assert(std::uint64_t(intrusive::le_u48_link<struct a>(0xba9876543210)) == 0xba9876543210);
+	using narrow_key = intrusive::endian_int<struct a, std::int64_t, std::endian::big, 5>;
+	assert(std::int64_t(narrow_key(-3)) == -3 and narrow_key(-3) < narrow_key(2));
+
+	using tree_type = packed_tree_type;
+	std::array<tuple_node<tree_type::left_type, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_type::key_type>, 100> nodes{};
+	auto root = std::ptrdiff_t{};
+	for (auto i = 0; i < 100; ++i) {
+		std::get<tree_type::key_type>(nodes[std::size_t(i)].ts) = i * 37 % 100;
+		root = red_black_tree::insert<tree_type>(nodes.begin(), root, nodes.begin() + i, std::less<>{});
+	}
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), root, std::less<>{}));
+	for (auto i = 0; i < 100; i += 2)
+		root = red_black_tree::erase<tree_type>(root, red_black_tree::find<tree_type>(nodes.begin(), root, i, std::less<>{}));
+	assert(red_black_tree::validate<tree_type>(std::span(nodes), root, std::less<>{}));
+	auto k = 1;
+	for (auto it = red_black_tree::begin<tree_type>(nodes.begin(), root); it not_eq red_black_tree::end<tree_type>(nodes.begin()); ++it, k += 2)
+		assert(std::get<tree_type::key_type>(it->ts) == k);
+	return k == 101;
+}
+
+[[nodiscard]] constexpr auto test_patch() noexcept
+{
+	using tree_key = typename tree_type::key_type;
+	auto equal = [](const auto& a, const auto& b) { return a.ts == b.ts; };
+	std::array<example_node, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	for (auto i = 0; i < 90; ++i)
+		root = red_black_tree::insert<tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	std::array<example_node, 100> old_nodes{};
+	old_nodes = nodes;
+	for (auto i = 90; i < 93; ++i)
+		root = red_black_tree::insert<tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	root = red_black_tree::erase<tree_type>(root, red_black_tree::find<tree_type>(base, root, tree_key{40}, std::less<>{}));
+
+	std::array<std::ptrdiff_t, 100> links{};
+	std::array<example_node, 100> values{};
+	auto [links_end, values_end] = patch::make_patch(old_nodes.begin(), old_nodes.end(), base, links.begin(), values.begin(), equal);
+	assert(links_end - links.begin() == values_end - values.begin());
+	assert(links_end - links.begin() < 30);
+
+	std::array<std::ptrdiff_t, 400> touched{};
+	auto touched_end = red_black_tree::neighbours<tree_type>(old_nodes.begin(), old_nodes.end(), links.begin(), links_end, std::copy(links.begin(), links_end, touched.begin()));
+	std::array<example_node, 100> replica{};
+	replica = old_nodes;
+	assert(patch::apply_patch(replica.begin(), replica.end(), links.begin(), links_end, values.begin()) == values_end);
+	assert(std::ranges::equal(replica, nodes, equal));
+	assert(red_black_tree::validate_nodes<tree_type>(replica.begin(), replica.end(), root, touched.begin(), touched_end, std::less<>{}));
+	assert(not red_black_tree::validate_nodes<tree_type>(replica.begin(), replica.end(), root, links.end() - 1, links.end(), std::less<>{}));
+
+	auto color = std::get<tree_type::color_type>(replica[std::size_t(root - 1)].ts);
+	std::get<tree_type::color_type>(replica[std::size_t(root - 1)].ts) = tree_type::color_type(not bool(color));
+	assert(not red_black_tree::validate_nodes<tree_type>(replica.begin(), replica.end(), root, touched.begin(), touched_end, std::less<>{}));
+	std::get<tree_type::color_type>(replica[std::size_t(root - 1)].ts) = color;
+	std::swap(std::get<tree_key>(replica[std::size_t(links[0] - 1)].ts), std::get<tree_key>(replica[std::size_t(links[1] - 1)].ts));
+	assert(not red_black_tree::validate_nodes<tree_type>(replica.begin(), replica.end(), root, touched.begin(), touched_end, std::less<>{}));
+
+	std::array<example_list, 100> list{};
+	auto head = std::ptrdiff_t{};
+	auto tail = std::ptrdiff_t{};
+	for (auto it = list.begin(); it not_eq list.begin() + 90; ++it) {
+		tail = double_list::push_back<list_type>(list.begin(), tail, it);
+		head = head ? head : tail;
+	}
+	std::array<example_list, 100> old_list{};
+	old_list = list;
+	tail = double_list::erase_after<list_type>(tail, double_list::begin<list_type>(list.begin(), std::ptrdiff_t{ 41 }));
+	tail = double_list::insert_after<list_type>(tail, double_list::begin<list_type>(list.begin(), std::ptrdiff_t{ 7 }), list.begin() + 95);
+
+	std::array<example_list, 100> list_values{};
+	auto [list_links_end, list_values_end] = patch::make_patch(old_list.begin(), old_list.end(), list.begin(), links.begin(), list_values.begin(), equal);
+	assert(list_links_end - links.begin() == 5);
+	touched_end = double_list::neighbours<list_type>(old_list.begin(), old_list.end(), links.begin(), list_links_end, std::copy(links.begin(), list_links_end, touched.begin()));
+	std::array<example_list, 100> list_replica{};
+	list_replica = old_list;
+	assert(patch::apply_patch(list_replica.begin(), list_replica.end(), links.begin(), list_links_end, list_values.begin()) == list_values_end);
+	assert(std::ranges::equal(list_replica, list, equal));
+	assert(double_list::validate_nodes<list_type>(list_replica.begin(), list_replica.end(), head, touched.begin(), touched_end));
+
+	list_replica = old_list;
+	patch::apply_patch(list_replica.begin(), list_replica.end(), links.begin() + 1, list_links_end, list_values.begin() + 1);
+	assert(not double_list::validate_nodes<list_type>(list_replica.begin(), list_replica.end(), head, touched.begin(), touched_end));
+
+	return true;
+}
+
+template <typename packed_tree_type, typename packed_link_type>
+[[nodiscard]] constexpr auto test_packed_color_tree(std::uint64_t color_mask) noexcept
+{
+	using tree_key = typename packed_tree_type::key_type;
+	std::array<tuple_node<typename packed_tree_type::left_type, typename packed_tree_type::right_type, typename packed_tree_type::parent_type, tree_key>, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto valid = [&] { return red_black_tree::validate<packed_tree_type>(std::span(nodes), root, std::less<>{}); };
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i) {
+		root = red_black_tree::insert<packed_tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	}
+	assert(valid());
+	assert(std::uint64_t(packed_link_type(get<packed_link_type>(nodes[std::size_t(root - 1)]))) & color_mask);
+	std::for_each(red_black_tree::begin<packed_tree_type>(base, root), red_black_tree::end<packed_tree_type>(base), [&, i = std::size_t{}](const auto& node) mutable
+	{
+		assert(&nodes[i++] == &node);
+	});
+
+	for (auto i = std::size_t{1}; i < 100; i += 2) {
+		root = red_black_tree::erase<packed_tree_type>(root, red_black_tree::find<packed_tree_type>(base, root, tree_key(i), std::less<>{}));
+	}
+	assert(valid());
+
+	auto a = red_black_tree::find<packed_tree_type>(base, root, tree_key(20), std::less<>{});
+	auto b = red_black_tree::find<packed_tree_type>(base, root, tree_key(40), std::less<>{});
+	get<tree_key>(*a) = tree_key(40);
+	get<tree_key>(*b) = tree_key(20);
+	root = red_black_tree::node_swap<packed_tree_type>(root, a, b);
+	assert(valid());
+	assert(red_black_tree::size<packed_tree_type>(base, root) == 50);
+
+	while (root) {
+		root = red_black_tree::erase<packed_tree_type>(root, red_black_tree::begin<packed_tree_type>(base, root));
+	}
+	assert(valid());
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_parentless_tree() noexcept
+{
+	using tree_key = typename parentless_tree_type::key_type;
+	using tree_left = typename parentless_tree_type::left_type;
+	std::array<tuple_node<tree_left, parentless_tree_type::right_type, parentless_tree_type::color_type, tree_key>, 100> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+	auto valid = [&] { return parentless_red_black_tree::validate<parentless_tree_type>(std::span(nodes), root, std::less<>{}) and parentless_red_black_tree::validate<parentless_tree_type>(base, std::span(nodes).end(), root, std::less<>{}); };
+	auto end = parentless_red_black_tree::end<parentless_tree_type>(base);
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i) {
+		root = parentless_red_black_tree::insert<parentless_tree_type>(base, root, base + i * 37 % 100, std::less<>{});
+	}
+	assert(valid());
+	assert(parentless_red_black_tree::size<parentless_tree_type>(base, root) == 100);
+
+	auto k = std::ptrdiff_t{};
+	for (auto it = parentless_red_black_tree::begin<parentless_tree_type>(base, root); it not_eq end; ++it)
+		assert(&*it == &nodes[k++]);
+	for (auto it = parentless_red_black_tree::rbegin<parentless_tree_type>(base, root); it not_eq parentless_red_black_tree::rend<parentless_tree_type>(base); ++it)
+		assert(&*it == &nodes[--k]);
+	for (auto it = parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(99), std::less<>{}); k < 100; --it)
+		assert(&*it == &nodes[99 - k++]);
+
+	assert(&*parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(42), std::less<>{}) == &nodes[42]);
+	assert(parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(100), std::less<>{}) == end);
+	assert(parentless_red_black_tree::lower_bound<parentless_tree_type>(base, root, tree_key(100), std::less<>{}) == end);
+	assert(&*parentless_red_black_tree::upper_bound<parentless_tree_type>(base, root, tree_key(41), std::less<>{}) == &nodes[42]);
+
+	auto leaf = parentless_red_black_tree::rbegin<parentless_tree_type>(base, root).link();
+	get<tree_left>(nodes[leaf - 1]) = tree_left(root);
+	assert(not valid());
+	get<tree_left>(nodes[leaf - 1]) = tree_left{};
+	assert(valid());
+
+	for (auto i = std::size_t{1}; i < 100; i += 2) {
+		root = parentless_red_black_tree::erase<parentless_tree_type>(root, parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(i), std::less<>{}));
+	}
+	assert(valid());
+	assert(parentless_red_black_tree::size<parentless_tree_type>(base, root) == 50);
+	assert(parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(41), std::less<>{}) == end);
+
+	auto it = parentless_red_black_tree::make_iterator<parentless_tree_type>(base, root, base + 10, std::less<>{});
+	assert(&*it == &nodes[10]);
+	get<tree_key>(nodes[11]) = tree_key(10);
+	root = parentless_red_black_tree::node_relink<parentless_tree_type>(root, base + 11, it);
+	assert(valid());
+	assert(&*parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(10), std::less<>{}) == &nodes[11]);
+
+	for (auto [a, b] : { std::pair{ 20, 40 }, std::pair{ 0, 2 }, std::pair{ 98, 50 } }) {
+		auto a_it = parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(a), std::less<>{});
+		auto b_it = parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(b), std::less<>{});
+		auto a_key = tree_key(get<tree_key>(*a_it));
+		get<tree_key>(*a_it) = tree_key(get<tree_key>(*b_it));
+		get<tree_key>(*b_it) = a_key;
+		root = parentless_red_black_tree::node_swap<parentless_tree_type>(root, a_it, b_it);
+		assert(valid());
+		assert(&*parentless_red_black_tree::find<parentless_tree_type>(base, root, tree_key(a), std::less<>{}) == &nodes[b]);
+	}
+	assert(parentless_red_black_tree::size<parentless_tree_type>(base, root) == 50);
+
+	while (not parentless_red_black_tree::empty<decltype(base)>(root)) {
+		root = parentless_red_black_tree::erase<parentless_tree_type>(root, parentless_red_black_tree::begin<parentless_tree_type>(base, root));
+	}
+	assert(valid());
+
+	return true;
+}
+
+[[nodiscard]] constexpr auto test_b_tree() noexcept
+{
+	using tree_key = b_tree_type::key_type;
+	using b_tree_node = std::tuple<b_tree_type::size_type, b_tree_type::level_type, b_tree_type::next_type, b_tree_type::prev_type, b_tree_type::keys_type, b_tree_type::links_type>;
+	std::array<tuple_node<tree_key>, 100> elements{};
+	std::array<b_tree_node, b_tree::node_capacity<b_tree_type>(100)> nodes{};
+	auto base = std::span(elements).begin();
+	auto node_base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(elements));
+	auto free_list = b_tree::init<b_tree_type>(node_base, std::span(nodes).end());
+	auto valid = [&] { return b_tree::validate<b_tree_type>(std::span(elements), std::span(nodes), root, std::less<>{}); };
+	auto end = b_tree::end<b_tree_type>(base, node_base);
+
+	for (auto i = std::ptrdiff_t{}; i < 100; ++i) {
+		auto [it, r, f] = b_tree::insert<b_tree_type>(base, node_base, root, free_list, base + i * 37 % 100, std::less<>{});
+		assert(&*it == &elements[std::size_t(i * 37 % 100)]);
+		root = r;
+		free_list = f;
+	}
+	assert(valid());
+	assert(b_tree::size<b_tree_type>(base, node_base, root) == 100);
+
+	auto k = std::ptrdiff_t{};
+	for (auto it = b_tree::begin<b_tree_type>(base, node_base, root); it not_eq end; ++it)
+		assert(&*it == &elements[std::size_t(k++)]);
+	for (auto it = b_tree::find<b_tree_type>(base, node_base, root, tree_key(99), std::less<>{}); k > 1; --it)
+		assert(&*it == &elements[std::size_t(--k)]);
+
+	assert(&*b_tree::find<b_tree_type>(base, node_base, root, tree_key(42), std::less<>{}) == &elements[42]);
+	assert(b_tree::find<b_tree_type>(base, node_base, root, tree_key(100), std::less<>{}) == end);
+	assert(b_tree::lower_bound<b_tree_type>(base, node_base, root, tree_key(100), std::less<>{}) == end);
+	assert(&*b_tree::upper_bound<b_tree_type>(base, node_base, root, tree_key(41), std::less<>{}) == &elements[42]);
+
+	get<tree_key>(elements[50]) = tree_key(51);
+	assert(not valid());
+	get<tree_key>(elements[50]) = tree_key(50);
+	assert(valid());
+
+	for (auto i = std::size_t{1}; i < 100; i += 2) {
+		auto [r, f] = b_tree::erase<b_tree_type>(root, free_list, b_tree::find<b_tree_type>(base, node_base, root, tree_key(i), std::less<>{}), std::less<>{});
+		root = r;
+		free_list = f;
+	}
+	assert(valid());
+	assert(b_tree::size<b_tree_type>(base, node_base, root) == 50);
+	assert(b_tree::find<b_tree_type>(base, node_base, root, tree_key(41), std::less<>{}) == end);
+	assert(&*b_tree::lower_bound<b_tree_type>(base, node_base, root, tree_key(41), std::less<>{}) == &elements[42]);
+
+	for (auto i = std::size_t{1}; i < 100; i += 2) {
+		get<tree_key>(elements[i]) = tree_key(i - 1);
+		auto [it, r, f] = b_tree::insert<b_tree_type>(base, node_base, root, free_list, base + std::ptrdiff_t(i), std::less<>{});
+		root = r;
+		free_list = f;
+	}
+	assert(valid());
+	auto [first, last] = b_tree::equal_range<b_tree_type>(base, node_base, root, tree_key(42), std::less<>{});
+	assert(&*first++ == &elements[42] and &*first++ == &elements[43] and first == last);
+	assert(&*b_tree::make_iterator<b_tree_type>(base, node_base, root, base + 43, std::less<>{}) == &elements[43]);
+
+	while (not b_tree::empty<decltype(node_base)>(root)) {
+		auto [r, f] = b_tree::erase<b_tree_type>(root, free_list, b_tree::begin<b_tree_type>(base, node_base, root), std::less<>{});
+		root = r;
+		free_list = f;
+	}
+	assert(valid());
+	assert(free_list);
+
+	return true;
+}
+
+constexpr auto assert_counted_tree(std::ranges::contiguous_range auto nodes, std::same_as<std::ptrdiff_t> auto root) noexcept
+{
+	using tree_key = typename counted_tree_type::key_type;
+	assert(red_black_tree::validate<counted_tree_type>(nodes, root, std::less<>{}));
+	auto n = red_black_tree::size<counted_tree_type>(nodes.begin(), root);
+	assert(n == std::distance(red_black_tree::begin<counted_tree_type>(nodes.begin(), root), red_black_tree::end<counted_tree_type>(nodes.begin())));
+	assert(red_black_tree::select<counted_tree_type>(nodes.begin(), root, n) == red_black_tree::end<counted_tree_type>(nodes.begin()));
+	assert(red_black_tree::rank<counted_tree_type>(root, red_black_tree::end<counted_tree_type>(nodes.begin())) == n);
+	auto k = std::ptrdiff_t{};
+	for (auto it = red_black_tree::begin<counted_tree_type>(nodes.begin(), root); it not_eq red_black_tree::end<counted_tree_type>(nodes.begin()); ++it, ++k) {
+		assert(red_black_tree::select<counted_tree_type>(nodes.begin(), root, k) == it);
+		assert(red_black_tree::rank<counted_tree_type>(root, it) == k);
+		auto key = tree_key(get<tree_key>(*it));
+		assert(red_black_tree::count_range<counted_tree_type>(nodes.begin(), root, tree_key{}, key, std::less<>{}) == k);
+		assert(red_black_tree::count_range<counted_tree_type>(nodes.begin(), root, key, tree_key(std::size_t(key) + 1), std::less<>{}) == 1);
+	}
+}
+
+[[nodiscard]] constexpr auto test_counted_tree() noexcept
+{
+	using tree_key = typename counted_tree_type::key_type;
+	using counted_node = tuple_node<tree_type::left_type, tree_type::right_type, tree_type::parent_type, tree_type::color_type, tree_key, counted_tree_type::count_type>;
+	std::array<counted_node, 64> nodes{};
+	auto base = std::span(nodes).begin();
+	auto root = init_tree_nodes<tree_key>(std::span(nodes));
+
+	assert(red_black_tree::size<counted_tree_type>(base, root) == 0);
+	for (const auto& node : std::views::iota(base, std::span(nodes).end()) | std::views::reverse)
+		root = red_black_tree::insert<counted_tree_type>(base, root, node, std::less<>{});
+	assert_counted_tree(std::span(nodes), root);
+	assert(red_black_tree::size<counted_tree_type>(base, root) == 64);
+	assert(red_black_tree::count_range<counted_tree_type>(base, root, tree_key{10}, tree_key{20}, std::less<>{}) == 10);
+	assert(red_black_tree::count_range<counted_tree_type>(base, root, tree_key{20}, tree_key{10}, std::less<>{}) == 0);
+
+	for (const auto& node : std::views::iota(base, std::span(nodes).end()) | std::views::filter([&](auto it) { return std::distance(base, it) % 3 == 0; }))
+		root = red_black_tree::erase<counted_tree_type>(root, red_black_tree::make_iterator<counted_tree_type>(base, node));
+	assert_counted_tree(std::span(nodes), root);
+	assert(red_black_tree::size<counted_tree_type>(base, root) == 42);
+
+	root = red_black_tree::node_relink<counted_tree_type>(root, base, red_black_tree::make_iterator<counted_tree_type>(base, base + 1));
+	get<tree_key>(nodes[0]) = tree_key(get<tree_key>(nodes[1]));
+	assert_counted_tree(std::span(nodes), root);
+
+	root = red_black_tree::node_swap<counted_tree_type>(root, red_black_tree::make_iterator<counted_tree_type>(base, base), red_black_tree::make_iterator<counted_tree_type>(base, base + 2));
+	std::swap(std::get<tree_key>(nodes[0].ts), std::get<tree_key>(nodes[2].ts));
+	assert_counted_tree(std::span(nodes), root);
+
+	root = init_tree_nodes<tree_key>(std::span(nodes));
+	root = red_black_tree::build_sorted<counted_tree_type>(base, base, std::span(nodes).end());
+	assert_counted_tree(std::span(nodes), root);
+
+	std::get<counted_tree_type::count_type>(nodes[std::size_t(root - 1)].ts) = counted_tree_type::count_type{};
+	assert(not red_black_tree::validate<counted_tree_type>(std::span(nodes), root, std::less<>{}));
+
+	return true;
+}
+
 constexpr auto assert_valid_list(std::ranges::contiguous_range auto nodes, std::same_as<std::ptrdiff_t> auto head) noexcept
 {
 	assert(double_list::validate<list_type>(nodes.begin(), nodes.end(), head));
@@ -984,6 +2386,53 @@ int main()
 {
 	static_assert(test_tree());
 
+	static_assert(test_tree_build());
+
+	static_assert(test_counted_tree());
+
+	static_assert(test_tree_set_operations());
+
+	static_assert(test_tree_hinted_insert());
+
+	static_assert(test_tree_forked_validate());
+
+	static_assert(test_tree_range_erase());
+
+	static_assert(test_tree_three_way());
+
+	static_assert(test_tree_batch_lookup());
+
+	static_assert(test_tree_relayout());
+
+	static_assert(test_static_search_tree());
+	assert(test_static_search_tree());
+
+	static_assert(test_prefixed_tree());
+
+	static_assert(test_digested_tree());
+	static_assert(test_aggregated_tree());
+	static_assert(test_interval_tree());
+	static_assert(test_flatten());
+	static_assert(test_patch());
+	static_assert(test_portable_tree());
+	static_assert(test_packed_links());
+	static_assert(test_undo_log());
+	assert(test_shared_tree());
+
+	static_assert(test_packed_color_tree<packed_color_tree_type, packed_color_tree_type::parent_type>(std::uint64_t{1} << 63));
+
+	static_assert(test_packed_color_tree<low_packed_color_tree_type, low_packed_color_tree_type::left_type>(1));
+
+	static_assert(red_black_tree::max_size<packed_color_tree_type, std::array<example_node, 1>::iterator>() == red_black_tree::max_size<std::array<example_node, 1>::iterator>());
+
+	static_assert(red_black_tree::max_size<low_packed_color_tree_type, std::array<example_node, 1>::iterator>() == 32767);
+
+	static_assert(test_parentless_tree());
+	static_assert(test_persistent_tree());
+	static_assert(test_wavl_tree());
+
+	static_assert(test_b_tree());
+
 	static_assert(test_list());
 
 	static_assert(test_slist());